@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include "devices/ide.h"
 #include "threads/malloc.h"
+#include "threads/trace.h"
 
 /* A block device. */
 struct block {
@@ -96,7 +97,9 @@ static void check_sector(struct block* block, block_sector_t sector) {
    per-block device locking is unneeded. */
 void block_read(struct block* block, block_sector_t sector, void* buffer) {
   check_sector(block, sector);
+  trace_event(TRACE_BLOCK_READ, sector);
   block->ops->read(block->aux, sector, buffer);
+  trace_event(TRACE_BLOCK_DONE, sector);
   block->read_cnt++;
 }
 
@@ -108,10 +111,64 @@ void block_read(struct block* block, block_sector_t sector, void* buffer) {
 void block_write(struct block* block, block_sector_t sector, const void* buffer) {
   check_sector(block, sector);
   ASSERT(block->type != BLOCK_FOREIGN);
+  trace_event(TRACE_BLOCK_WRITE, sector);
   block->ops->write(block->aux, sector, buffer);
+  trace_event(TRACE_BLOCK_DONE, sector);
   block->write_cnt++;
 }
 
+/* Reads CNT consecutive sectors, starting at SECTOR, from BLOCK
+   into BUFFER, which must have room for CNT * BLOCK_SECTOR_SIZE
+   bytes.  If BLOCK's driver can, it transfers them all with a
+   single request, which is much faster than CNT calls to
+   block_read().
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void block_read_multi(struct block* block, block_sector_t sector, void* buffer,
+                      block_sector_t cnt) {
+  block_sector_t i;
+
+  ASSERT(cnt > 0);
+  if (block->ops->read_multi == NULL) {
+    for (i = 0; i < cnt; i++)
+      block_read(block, sector + i, (uint8_t*)buffer + i * BLOCK_SECTOR_SIZE);
+    return;
+  }
+
+  check_sector(block, sector);
+  check_sector(block, sector + cnt - 1);
+  trace_event(TRACE_BLOCK_READ, sector);
+  block->ops->read_multi(block->aux, sector, buffer, cnt);
+  trace_event(TRACE_BLOCK_DONE, sector);
+  block->read_cnt += cnt;
+}
+
+/* Writes CNT consecutive sectors, starting at SECTOR, to BLOCK
+   from BUFFER, which must contain CNT * BLOCK_SECTOR_SIZE bytes,
+   in a single request if BLOCK's driver can.  Returns after the
+   block device has acknowledged receiving all the data.
+   Internally synchronizes accesses to block devices, so external
+   per-block device locking is unneeded. */
+void block_write_multi(struct block* block, block_sector_t sector, const void* buffer,
+                       block_sector_t cnt) {
+  block_sector_t i;
+
+  ASSERT(cnt > 0);
+  if (block->ops->write_multi == NULL) {
+    for (i = 0; i < cnt; i++)
+      block_write(block, sector + i, (const uint8_t*)buffer + i * BLOCK_SECTOR_SIZE);
+    return;
+  }
+
+  check_sector(block, sector);
+  check_sector(block, sector + cnt - 1);
+  ASSERT(block->type != BLOCK_FOREIGN);
+  trace_event(TRACE_BLOCK_WRITE, sector);
+  block->ops->write_multi(block->aux, sector, buffer, cnt);
+  trace_event(TRACE_BLOCK_DONE, sector);
+  block->write_cnt += cnt;
+}
+
 /* Returns the number of sectors in BLOCK. */
 block_sector_t block_size(struct block* block) { return block->size; }
 
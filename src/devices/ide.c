@@ -50,6 +50,9 @@
 #define CMD_READ_SECTOR_RETRY 0x20  /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30 /* WRITE SECTOR with retries. */
 
+/* Most sectors that one READ or WRITE SECTOR command transfers. */
+#define IDE_MULTI_MAX 256
+
 /* An ATA device. */
 struct ata_disk {
   char name[8];            /* Name, e.g. "hda". */
@@ -83,7 +86,7 @@ static void reset_channel(struct channel*);
 static bool check_device_type(struct ata_disk*);
 static void identify_ata_device(struct ata_disk*);
 
-static void select_sector(struct ata_disk*, block_sector_t);
+static void select_sector(struct ata_disk*, block_sector_t, block_sector_t cnt);
 static void issue_pio_command(struct channel*, uint8_t command);
 static void input_sector(struct channel*, void*);
 static void output_sector(struct channel*, const void*);
@@ -306,6 +309,74 @@ static char* descramble_ata_string(char* string, int size) {
   return string;
 }
 
+/* Reads CNT sectors starting at SEC_NO from disk D into BUFFER,
+   which must have room for CNT * BLOCK_SECTOR_SIZE bytes.  Each
+   command transfers up to IDE_MULTI_MAX sectors, with the disk
+   interrupting once per sector as each becomes ready.  Only swap
+   uses this path; single-sector reads go through ide_read().
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+static void ide_read_multi(void* d_, block_sector_t sec_no, void* buffer, block_sector_t cnt) {
+  struct ata_disk* d = d_;
+  struct channel* c = d->channel;
+  uint8_t* p = buffer;
+
+  lock_acquire(&c->lock);
+  while (cnt > 0) {
+    block_sector_t n = cnt < IDE_MULTI_MAX ? cnt : IDE_MULTI_MAX;
+    block_sector_t i;
+
+    select_sector(d, sec_no, n);
+    issue_pio_command(c, CMD_READ_SECTOR_RETRY);
+    for (i = 0; i < n; i++) {
+      sema_down(&c->completion_wait);
+      if (!wait_while_busy(d))
+        PANIC("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no + i);
+      input_sector(c, p);
+      p += BLOCK_SECTOR_SIZE;
+    }
+    sec_no += n;
+    cnt -= n;
+  }
+  lock_release(&c->lock);
+}
+
+/* Writes CNT sectors starting at SEC_NO to disk D from BUFFER,
+   which must contain CNT * BLOCK_SECTOR_SIZE bytes.  Returns
+   after the disk has acknowledged receiving the data.  The disk
+   is ready for the first sector of each command right away, and
+   interrupts when it is ready for each of the others and again
+   once it has taken the last.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+static void ide_write_multi(void* d_, block_sector_t sec_no, const void* buffer,
+                            block_sector_t cnt) {
+  struct ata_disk* d = d_;
+  struct channel* c = d->channel;
+  const uint8_t* p = buffer;
+
+  lock_acquire(&c->lock);
+  while (cnt > 0) {
+    block_sector_t n = cnt < IDE_MULTI_MAX ? cnt : IDE_MULTI_MAX;
+    block_sector_t i;
+
+    select_sector(d, sec_no, n);
+    issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
+    for (i = 0; i < n; i++) {
+      if (i > 0)
+        sema_down(&c->completion_wait);
+      if (!wait_while_busy(d))
+        PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no + i);
+      output_sector(c, p);
+      p += BLOCK_SECTOR_SIZE;
+    }
+    sema_down(&c->completion_wait);
+    sec_no += n;
+    cnt -= n;
+  }
+  lock_release(&c->lock);
+}
+
 /* Reads sector SEC_NO from disk D into BUFFER, which must have
    room for BLOCK_SECTOR_SIZE bytes.
    Internally synchronizes accesses to disks, so external
@@ -314,7 +385,7 @@ static void ide_read(void* d_, block_sector_t sec_no, void* buffer) {
   struct ata_disk* d = d_;
   struct channel* c = d->channel;
   lock_acquire(&c->lock);
-  select_sector(d, sec_no);
+  select_sector(d, sec_no, 1);
   issue_pio_command(c, CMD_READ_SECTOR_RETRY);
   sema_down(&c->completion_wait);
   if (!wait_while_busy(d))
@@ -332,7 +403,7 @@ static void ide_write(void* d_, block_sector_t sec_no, const void* buffer) {
   struct ata_disk* d = d_;
   struct channel* c = d->channel;
   lock_acquire(&c->lock);
-  select_sector(d, sec_no);
+  select_sector(d, sec_no, 1);
   issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
   if (!wait_while_busy(d))
     PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no);
@@ -341,18 +412,20 @@ static void ide_write(void* d_, block_sector_t sec_no, const void* buffer) {
   lock_release(&c->lock);
 }
 
-static struct block_operations ide_operations = {ide_read, ide_write};
+static struct block_operations ide_operations = {ide_read, ide_write, ide_read_multi,
+                                                 ide_write_multi};
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
-static void select_sector(struct ata_disk* d, block_sector_t sec_no) {
+   writes SEC_NO and the number of sectors CNT to the disk's
+   sector selection registers.  (We use LBA mode.) */
+static void select_sector(struct ata_disk* d, block_sector_t sec_no, block_sector_t cnt) {
   struct channel* c = d->channel;
 
   ASSERT(sec_no < (1UL << 28));
+  ASSERT(cnt >= 1 && cnt <= IDE_MULTI_MAX);
 
   select_device_wait(d);
-  outb(reg_nsect(c), 1);
+  outb(reg_nsect(c), cnt); /* 256 is written as 0. */
   outb(reg_lbal(c), sec_no);
   outb(reg_lbam(c), sec_no >> 8);
   outb(reg_lbah(c), (sec_no >> 16));
@@ -11,9 +11,6 @@
 #define PIT_PORT_CONTROL 0x43                        /* Control port. */
 #define PIT_PORT_COUNTER(CHANNEL) (0x40 + (CHANNEL)) /* Counter port. */
 
-/* PIT cycles per second. */
-#define PIT_HZ 1193180
-
 /* Configure the given CHANNEL in the PIT.  In a PC, the PIT's
    three output channels are hooked up like this:
 
@@ -39,7 +36,8 @@
        it is 1, for the second half it is 0.  This is useful for
        generating a tone on a speaker.
 
-     - Other modes are less useful.
+     - Other modes are less useful, except for mode 0, which
+       pit_configure_oneshot() uses.
 
    FREQUENCY is the number of periods per second, in Hz. */
 void pit_configure_channel(int channel, int mode, int frequency) {
@@ -75,3 +73,56 @@ void pit_configure_channel(int channel, int mode, int frequency) {
   outb(PIT_PORT_COUNTER(channel), count >> 8);
   intr_set_level(old_level);
 }
+
+/* Configures CHANNEL in mode 0, interrupt on terminal count, to
+   count down COUNT PIT cycles once.  The channel's output drops
+   to 0 and rises back to 1, raising the interrupt for channel 0,
+   when the count reaches 0, and then stays at 1.  A COUNT of 0
+   stands for 65536. */
+void pit_configure_oneshot(int channel, uint16_t count) {
+  enum intr_level old_level;
+
+  ASSERT(channel == 0 || channel == 2);
+
+  old_level = intr_disable();
+  outb(PIT_PORT_CONTROL, (channel << 6) | 0x30);
+  outb(PIT_PORT_COUNTER(channel), count);
+  outb(PIT_PORT_COUNTER(channel), count >> 8);
+  intr_set_level(old_level);
+}
+
+/* Returns the number of PIT cycles left in CHANNEL's current
+   count. */
+uint16_t pit_read_count(int channel) {
+  enum intr_level old_level;
+  uint16_t count;
+
+  ASSERT(channel == 0 || channel == 2);
+
+  /* Latch the counter, then read it low byte first. */
+  old_level = intr_disable();
+  outb(PIT_PORT_CONTROL, channel << 6);
+  count = inb(PIT_PORT_COUNTER(channel));
+  count |= inb(PIT_PORT_COUNTER(channel)) << 8;
+  intr_set_level(old_level);
+
+  return count;
+}
+
+/* Returns the state of CHANNEL's output, which in mode 0 tells
+   whether the count has reached 0. */
+bool pit_read_output(int channel) {
+  enum intr_level old_level;
+  uint8_t status;
+
+  ASSERT(channel == 0 || channel == 2);
+
+  /* Read-back command latching only the status byte, whose top
+     bit is the output. */
+  old_level = intr_disable();
+  outb(PIT_PORT_CONTROL, 0xe0 | (2 << channel));
+  status = inb(PIT_PORT_COUNTER(channel));
+  intr_set_level(old_level);
+
+  return (status & 0x80) != 0;
+}
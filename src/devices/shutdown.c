@@ -5,9 +5,13 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "threads/io.h"
+#include "threads/profile.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
+#include "userprog/futex.h"
+#include "userprog/process.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
@@ -81,6 +85,8 @@ void shutdown_power_off(void) {
   filesys_done();
 #endif
 
+  trace_dump();
+  profile_dump();
   print_stats();
 
   printf("Powering off...\n");
@@ -123,5 +129,7 @@ static void print_stats(void) {
   kbd_print_stats();
 #ifdef USERPROG
   exception_print_stats();
+  process_print_stats();
+  futex_print_stats();
 #endif
 }
@@ -4,7 +4,9 @@
 #include <round.h>
 #include <stdio.h>
 #include "devices/pit.h"
+#include "devices/tsc.h"
 #include "threads/interrupt.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 
@@ -20,50 +22,88 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
-/* Number of loops per timer tick.
-   Initialized by timer_calibrate(). */
-static unsigned loops_per_tick;
-
-//list of threads waiting to be woken up at a certain time
-struct list timer_wait_list;
+/* Time stamp counter value when timer_init() ran, from which
+   timer_now_ns() counts. */
+static uint64_t boot_tsc;
+
+/* Hierarchical timing wheel holding every pending timer.
+
+   Level L has TIMER_WHEEL_SLOTS slots, each covering
+   TIMER_WHEEL_SLOTS**L ticks, so the wheel as a whole reaches
+   TIMER_WHEEL_SLOTS**TIMER_WHEEL_LEVELS ticks (about 46 hours at
+   100 Hz) past wheel_ticks.  A timer goes into the lowest level
+   whose range covers its expiry, in the slot that its expiry
+   falls in, which takes O(1).  Each tick fires the timers in one
+   level-0 slot.  Whenever a level's slot index wraps to 0, the
+   next slot of the level above is emptied and its timers are
+   reinserted into lower levels, now that they are closer.  A
+   timer is moved at most TIMER_WHEEL_LEVELS - 1 times, so expiry
+   is amortized O(1) no matter how many timers are pending.
+   Timers further out than the wheel reaches are parked in the
+   last slot of the top level until they come within range. */
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_LEVELS 4
+static struct list timer_wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+static int64_t wheel_ticks; /* Last tick whose timers have been run. */
+
+/* Tickless idle.
+
+   If true, the idle thread stops the periodic tick while nothing
+   is due: it reprograms the PIT to interrupt once, at the next
+   tick on which the timer wheel has work, and halts.  The first
+   external interrupt after that, whether from the PIT or any
+   other device, reads how far the PIT got, runs the ticks that
+   passed in the meantime, and restores the periodic tick.  The
+   PIT's 16-bit counter limits each stretch to TICKLESS_MAX_TICKS
+   ticks.  The one-shot is armed to end on a tick boundary, so
+   the tick phase is kept when the PIT wakes us, but the
+   fraction of a tick since the last boundary is lost when
+   another device does.
+
+   Controlled by kernel command-line option "-tickless". */
+bool timer_tickless;
+
+#define PIT_COUNT_PER_TICK ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+#define TICKLESS_MAX_TICKS (UINT16_MAX / PIT_COUNT_PER_TICK)
+static int64_t tickless_ticks; /* Ticks in the armed one-shot, or 0 if periodic. */
+static uint16_t tickless_count; /* PIT cycles in the armed one-shot. */
+static uint16_t tickless_first; /* PIT cycles until the first tick boundary. */
 
 static intr_handler_func timer_interrupt;
-static bool too_many_loops(unsigned loops);
-static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
 static void real_time_delay(int64_t num, int32_t denom);
-static bool timer_less(const struct list_elem* e1, const struct list_elem* e2, void* aux);
+static void wheel_insert(struct timer*);
+static bool wheel_cascade_slot(int level);
+static void wheel_cascade(int level);
+static void wheel_advance(void);
+static int64_t wheel_idle_ticks(int64_t max);
+static void timer_tick(void);
+static void wake_sleeper(void* t);
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
    and registers the corresponding interrupt. */
 void timer_init(void) {
+  boot_tsc = tsc_read();
   pit_configure_channel(0, 2, TIMER_FREQ);
   intr_register_ext(0x20, timer_interrupt, "8254 Timer");
-  list_init(&timer_wait_list);
+  softirq_register(SOFTIRQ_TIMER, wheel_advance);
+  for (int level = 0; level < TIMER_WHEEL_LEVELS; level++)
+    for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+      list_init(&timer_wheel[level][slot]);
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates the time stamp counter, used for timer_now_ns() and
+   brief delays, unless its rate was given on the command line. */
 void timer_calibrate(void) {
-  unsigned high_bit, test_bit;
-
   ASSERT(intr_get_level() == INTR_ON);
-  printf("Calibrating timer...  ");
 
-  /* Approximate loops_per_tick as the largest power-of-two
-     still less than one timer tick. */
-  loops_per_tick = 1u << 10;
-  while (!too_many_loops(loops_per_tick << 1)) {
-    loops_per_tick <<= 1;
-    ASSERT(loops_per_tick != 0);
+  if (tsc_khz() != 0) {
+    printf("Using %" PRIu32 " kHz TSC.\n", tsc_khz());
+    return;
   }
-
-  /* Refine the next 8 bits of loops_per_tick. */
-  high_bit = loops_per_tick;
-  for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
-    if (!too_many_loops(loops_per_tick | test_bit))
-      loops_per_tick |= test_bit;
-
-  printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+  printf("Calibrating timer...  ");
+  printf("%" PRIu32 " kHz TSC.\n", tsc_calibrate());
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -78,31 +118,83 @@ int64_t timer_ticks(void) {
    should be a value once returned by timer_ticks(). */
 int64_t timer_elapsed(int64_t then) { return timer_ticks() - then; }
 
-bool timer_less(const struct list_elem* e1, const struct list_elem* e2, void* aux) {
-  struct thread* t1 = list_entry(e1, struct thread, elem);
-  struct thread* t2 = list_entry(e2, struct thread, elem);
-  return t1->wakeup_time < t2->wakeup_time;
+/* Returns the number of nanoseconds since the OS booted.  Until
+   timer_calibrate() has run, this has only tick resolution. */
+uint64_t timer_now_ns(void) {
+  if (tsc_khz() == 0)
+    return timer_ticks() * (NSEC_PER_SEC / TIMER_FREQ);
+  return tsc_to_ns(tsc_read() - boot_tsc);
+}
+
+/* Initializes TIMER to call FUNC, passing AUX, when it expires.
+   The timer is not armed until passed to timer_add(). */
+void timer_setup(struct timer* timer, timer_func* func, void* aux) {
+  ASSERT(timer != NULL);
+  ASSERT(func != NULL);
+
+  timer->func = func;
+  timer->aux = aux;
+  timer->pending = false;
+}
+
+/* Arms TIMER to expire at tick EXPIRES, or at the next tick if
+   EXPIRES has already passed, replacing any expiry it was armed
+   with before.  TIMER's function is called from the timer
+   softirq with interrupts off, after TIMER has been disarmed, so
+   it may rearm TIMER itself. */
+void timer_add(struct timer* timer, int64_t expires) {
+  enum intr_level old_level = intr_disable();
+
+  if (timer->pending)
+    list_remove(&timer->elem);
+  timer->expires = expires > wheel_ticks ? expires : wheel_ticks + 1;
+  timer->pending = true;
+  wheel_insert(timer);
+
+  intr_set_level(old_level);
+}
+
+/* Disarms TIMER.  Returns true if it was armed, false if it had
+   already expired or was never armed. */
+bool timer_cancel(struct timer* timer) {
+  enum intr_level old_level = intr_disable();
+  bool was_pending = timer->pending;
+
+  if (was_pending) {
+    list_remove(&timer->elem);
+    timer->pending = false;
+  }
+
+  intr_set_level(old_level);
+  return was_pending;
 }
 
+/* Returns true if TIMER is armed and has not yet expired. */
+bool timer_pending(const struct timer* timer) { return timer->pending; }
+
 /* Sleeps for approximately TICKS timer ticks.  Interrupts must
    be turned on. */
 void timer_sleep(int64_t ticks) {
+  struct timer timer;
+
   if (ticks <= 0)
     return;
   ASSERT(intr_get_level() == INTR_ON);
   int64_t start = timer_ticks();
-  struct thread* t = thread_current();
-  t->wakeup_time = start + ticks;
 
+  /* The timer lives on our stack, which is safe because we stay
+     blocked until it has expired. */
   enum intr_level old_level = intr_disable();
-  // add thread to timer_wait_list and sort
-  list_insert_ordered(&timer_wait_list, &t->elem, timer_less, NULL);
-  // thread_block() must be called with interrupts off
+  timer_setup(&timer, wake_sleeper, thread_current());
+  timer_add(&timer, start + ticks);
   thread_block();
-
   intr_set_level(old_level);
 }
 
+/* Timer function for timer_sleep(), which wakes up sleeping
+   thread T. */
+static void wake_sleeper(void* t) { thread_wakeup(t); }
+
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
    turned on. */
 void timer_msleep(int64_t ms) { real_time_sleep(ms, 1000); }
@@ -145,39 +237,165 @@ void timer_ndelay(int64_t ns) { real_time_delay(ns, 1000 * 1000 * 1000); }
 /* Prints timer statistics. */
 void timer_print_stats(void) { printf("Timer: %" PRId64 " ticks\n", timer_ticks()); }
 
+/* Stops the periodic tick until the next tick on which a timer
+   expires, if tickless idle is enabled and that is at least two
+   ticks away.  Called by the idle thread, with interrupts off,
+   just before it halts. */
+void timer_tickless_enter(void) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (!timer_tickless || tickless_ticks != 0)
+    return;
+
+  int64_t idle_ticks = wheel_idle_ticks(TICKLESS_MAX_TICKS);
+  if (idle_ticks < 2)
+    return;
+
+  /* Keep the tick phase by counting out the rest of the current
+     period before the whole ones. */
+  tickless_first = pit_read_count(0);
+  if (tickless_first == 0 || tickless_first > PIT_COUNT_PER_TICK)
+    tickless_first = PIT_COUNT_PER_TICK;
+  tickless_count = tickless_first + (idle_ticks - 1) * PIT_COUNT_PER_TICK;
+  tickless_ticks = idle_ticks;
+  pit_configure_oneshot(0, tickless_count);
+}
+
+/* Restores the periodic tick if tickless idle stopped it, and
+   runs the ticks that have passed since then.  Called at the
+   start of every external interrupt. */
+void timer_tickless_exit(void) {
+  ASSERT(intr_context());
+
+  if (tickless_ticks == 0)
+    return;
+
+  /* If the one-shot expired, the PIT interrupt delivers the last
+     tick itself, whether this is that interrupt or it is still
+     pending.  The count is read before the output: once the count
+     reaches 0 it wraps around to 0xffff and keeps going, so a
+     count read after the output was seen low could come from
+     after expiry, and a count read before it, with the output
+     still low, cannot. */
+  uint16_t count = pit_read_count(0);
+  int64_t elapsed;
+  if (pit_read_output(0))
+    elapsed = tickless_ticks - 1;
+  else {
+    uint16_t cycles = tickless_count - count;
+    elapsed = cycles < tickless_first ? 0 : (cycles - tickless_first) / PIT_COUNT_PER_TICK + 1;
+  }
+
+  tickless_ticks = 0;
+  pit_configure_channel(0, 2, TIMER_FREQ);
+  while (elapsed-- > 0)
+    timer_tick();
+}
+
 /* Timer interrupt handler. */
-static void timer_interrupt(struct intr_frame* args UNUSED) {
+static void timer_interrupt(struct intr_frame* args) {
+  profile_sample(args);
+  timer_tick();
+}
+
+/* Advances the tick count by one and does the scheduler's
+   per-tick work.  Timers that expire are left to the timer
+   softirq. */
+static void timer_tick(void) {
   ticks++;
-  thread_tick(timer_ticks());
+  softirq_raise(SOFTIRQ_TIMER);
+  thread_tick(ticks);
 }
 
-/* Returns true if LOOPS iterations waits for more than one timer
-   tick, otherwise false. */
-static bool too_many_loops(unsigned loops) {
-  /* Wait for a timer tick. */
-  int64_t start = ticks;
-  while (ticks == start)
-    barrier();
+/* Puts pending TIMER into the timer wheel slot for its expiry,
+   relative to wheel_ticks.
+
+   A timer that expires within TIMER_WHEEL_SLOTS ticks goes into
+   level 0, in the slot that will be run at its expiry tick.
+   Otherwise it goes into the lowest level L whose slots, each
+   TIMER_WHEEL_SLOTS**L ticks wide, still reach it.  It always
+   lands in a slot after the current one, which has already been
+   cascaded, and at most one full turn ahead, so it is cascaded
+   when the slot that contains its expiry begins. */
+static void wheel_insert(struct timer* timer) {
+  int64_t delta = timer->expires - wheel_ticks;
+  int64_t expires = timer->expires;
+  int level;
+
+  ASSERT(delta >= 0);
+
+  for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++)
+    if (delta < (int64_t)1 << ((level + 1) * TIMER_WHEEL_BITS))
+      break;
+  if (delta >= (int64_t)1 << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS))
+    expires = wheel_ticks + ((int64_t)1 << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) - 1;
+
+  int slot = (expires >> (level * TIMER_WHEEL_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+  list_push_back(&timer_wheel[level][slot], &timer->elem);
+}
 
-  /* Run LOOPS loops. */
-  start = ticks;
-  busy_wait(loops);
+/* Empties LEVEL's slot for the current wheel_ticks into lower
+   levels.  Returns true if that slot was the level's first, in
+   which case the level above is due to cascade too. */
+static bool wheel_cascade_slot(int level) {
+  int slot = (wheel_ticks >> (level * TIMER_WHEEL_BITS)) & (TIMER_WHEEL_SLOTS - 1);
+  struct list* list = &timer_wheel[level][slot];
 
-  /* If the tick count changed, we iterated too long. */
-  barrier();
-  return start != ticks;
+  while (!list_empty(list))
+    wheel_insert(list_entry(list_pop_front(list), struct timer, elem));
+  return slot == 0;
 }
 
-/* Iterates through a simple loop LOOPS times, for implementing
-   brief delays.
+/* Cascades every level from LEVEL up whose slot index has just
+   wrapped around. */
+static void wheel_cascade(int level) {
+  while (level < TIMER_WHEEL_LEVELS && wheel_cascade_slot(level))
+    level++;
+}
 
-   Marked NO_INLINE because code alignment can significantly
-   affect timings, so that if this function was inlined
-   differently in different places the results would be difficult
-   to predict. */
-static void NO_INLINE busy_wait(int64_t loops) {
-  while (loops-- > 0)
-    barrier();
+/* Returns the number of ticks, between 1 and MAX, from
+   wheel_ticks to the next tick on which a timer may expire.  A
+   tick on which higher levels cascade counts as one, because the
+   timers cascaded then are not known yet. */
+static int64_t wheel_idle_ticks(int64_t max) {
+  int64_t t;
+
+  for (t = wheel_ticks + 1; t < wheel_ticks + max; t++) {
+    int slot = t & (TIMER_WHEEL_SLOTS - 1);
+    if (slot == 0 || !list_empty(&timer_wheel[0][slot]))
+      break;
+  }
+  return t - wheel_ticks;
+}
+
+/* Runs every timer that expires at or before the current tick,
+   in order of expiry, as the timer softirq.  Called with interrupts on, which are
+   turned off only to run one timer or cascade one tick's slots,
+   so that a burst of expiring timers does not hold off other
+   interrupts for its whole length. */
+static void wheel_advance(void) {
+  enum intr_level old_level = intr_disable();
+
+  while (wheel_ticks < ticks) {
+    wheel_ticks++;
+    if ((wheel_ticks & (TIMER_WHEEL_SLOTS - 1)) == 0)
+      wheel_cascade(1);
+
+    struct list* list = &timer_wheel[0][wheel_ticks & (TIMER_WHEEL_SLOTS - 1)];
+    while (!list_empty(list)) {
+      struct timer* timer = list_entry(list_pop_front(list), struct timer, elem);
+      ASSERT(timer->expires == wheel_ticks);
+      timer->pending = false;
+      timer->func(timer->aux);
+
+      intr_set_level(old_level);
+      intr_disable();
+    }
+    intr_set_level(old_level);
+    intr_disable();
+  }
+
+  intr_set_level(old_level);
 }
 
 /* Sleep for approximately NUM/DENOM seconds. */
@@ -189,24 +407,30 @@ static void real_time_sleep(int64_t num, int32_t denom) {
      1 s / TIMER_FREQ ticks
   */
   int64_t ticks = num * TIMER_FREQ / denom;
+  uint64_t deadline = timer_now_ns() + num * (NSEC_PER_SEC / denom);
 
   ASSERT(intr_get_level() == INTR_ON);
+  ASSERT(NSEC_PER_SEC % denom == 0);
   if (ticks > 0) {
     /* We're waiting for at least one full timer tick.  Use
          timer_sleep() because it will yield the CPU to other
          processes. */
     timer_sleep(ticks);
-  } else {
-    /* Otherwise, use a busy-wait loop for more accurate
-         sub-tick timing. */
-    real_time_delay(num, denom);
   }
+
+  /* Busy-wait for whatever part of a tick is left, for more
+     accurate sub-tick timing. */
+  while (timer_now_ns() < deadline)
+    barrier();
 }
 
 /* Busy-wait for approximately NUM/DENOM seconds. */
 static void real_time_delay(int64_t num, int32_t denom) {
-  /* Scale the numerator and denominator down by 1000 to avoid
-     the possibility of overflow. */
-  ASSERT(denom % 1000 == 0);
-  busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+  uint64_t start = tsc_read();
+  uint64_t cycles;
+
+  ASSERT(NSEC_PER_SEC % denom == 0);
+  cycles = tsc_from_ns(num * (NSEC_PER_SEC / denom));
+  while (tsc_read() - start < cycles)
+    barrier();
 }
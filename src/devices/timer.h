@@ -1,17 +1,43 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Nanoseconds per second. */
+#define NSEC_PER_SEC 1000000000
+
+/* Called with interrupts off, from the timer softirq, once a
+   timer expires. */
+typedef void timer_func(void* aux);
+
+/* A one-shot kernel timer.  Initialize with timer_setup(), then
+   arm with timer_add(). */
+struct timer {
+  struct list_elem elem; /* Element in a timer wheel slot. */
+  int64_t expires;       /* Tick at which to call FUNC. */
+  timer_func* func;      /* Function to call. */
+  void* aux;             /* Auxiliary data for FUNC. */
+  bool pending;          /* Armed and not yet expired or canceled? */
+};
+
 void timer_init(void);
 void timer_calibrate(void);
 
 int64_t timer_ticks(void);
 int64_t timer_elapsed(int64_t);
+uint64_t timer_now_ns(void);
+
+/* Callback timers. */
+void timer_setup(struct timer*, timer_func*, void* aux);
+void timer_add(struct timer*, int64_t expires);
+bool timer_cancel(struct timer*);
+bool timer_pending(const struct timer*);
 
 /* Sleep and yield the CPU to other threads. */
 void timer_sleep(int64_t ticks);
@@ -24,6 +50,11 @@ void timer_mdelay(int64_t milliseconds);
 void timer_udelay(int64_t microseconds);
 void timer_ndelay(int64_t nanoseconds);
 
+/* Tickless idle. */
+extern bool timer_tickless;
+void timer_tickless_enter(void);
+void timer_tickless_exit(void);
+
 void timer_print_stats(void);
 
 #endif /* devices/timer.h */
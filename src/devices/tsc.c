@@ -0,0 +1,92 @@
+#include "devices/tsc.h"
+#include <debug.h>
+#include "devices/pit.h"
+#include "threads/interrupt.h"
+#include "threads/io.h"
+
+/* Time stamp counter clock source.
+
+   The TSC counts CPU cycles, so it can be read in a few
+   instructions with far finer resolution than the PIT, but its
+   rate has to be measured.  tsc_calibrate() does that against
+   PIT channel 2, whose gate we control through the PC speaker
+   port: it counts the TSC cycles that pass while the PIT counts
+   down CALIBRATE_PIT_COUNT of its own, a few times, and keeps
+   the least, which has the least overhead.  The result can also
+   be given on the command line with "-tsc-khz", which skips the
+   measurement.
+
+   Cycles are converted to nanoseconds by multiplying by ns_mult
+   and shifting right by TSC_NS_SHIFT, with ns_mult chosen so
+   that this equals 1,000,000 / tsc_khz. */
+
+/* Speaker port.  Bit 0 gates PIT channel 2, and bit 1 connects
+   its output to the speaker. */
+#define SPEAKER_PORT_GATE 0x61
+#define SPEAKER_GATE_PIT 0x01
+#define SPEAKER_GATE_SPEAKER 0x02
+
+/* PIT cycles per calibration run, about 5 ms, and number of
+   runs. */
+#define CALIBRATE_PIT_COUNT (PIT_HZ / 200)
+#define CALIBRATE_RUNS 3
+
+/* Keeps ns_mult below 2**32 for any TSC faster than 1 MHz. */
+#define TSC_NS_SHIFT 22
+
+static uint32_t khz;     /* TSC cycles per millisecond, or 0 if unknown. */
+static uint32_t ns_mult; /* Nanoseconds per cycle, times 2**TSC_NS_SHIFT. */
+
+/* Measures the TSC rate against the PIT, records it, and returns
+   it in kHz. */
+uint32_t tsc_calibrate(void) {
+  uint64_t best = UINT64_MAX;
+  enum intr_level old_level;
+  uint8_t gate;
+  int i;
+
+  old_level = intr_disable();
+  gate = inb(SPEAKER_PORT_GATE);
+  outb(SPEAKER_PORT_GATE, (gate & ~SPEAKER_GATE_SPEAKER) | SPEAKER_GATE_PIT);
+  for (i = 0; i < CALIBRATE_RUNS; i++) {
+    uint64_t start, cycles;
+
+    pit_configure_oneshot(2, CALIBRATE_PIT_COUNT);
+    start = tsc_read();
+    while (!pit_read_output(2))
+      continue;
+    cycles = tsc_read() - start;
+    if (cycles < best)
+      best = cycles;
+  }
+  outb(SPEAKER_PORT_GATE, gate);
+  intr_set_level(old_level);
+
+  tsc_set_khz(best * PIT_HZ / CALIBRATE_PIT_COUNT / 1000);
+  return khz;
+}
+
+/* Sets the TSC rate to RATE kHz. */
+void tsc_set_khz(uint32_t rate) {
+  ASSERT(rate >= 1000);
+
+  khz = rate;
+  ns_mult = ((uint64_t)1000000 << TSC_NS_SHIFT) / khz;
+}
+
+/* Returns the TSC rate in kHz, or 0 if it is not yet known. */
+uint32_t tsc_khz(void) { return khz; }
+
+/* Converts CYCLES of the TSC to nanoseconds. */
+uint64_t tsc_to_ns(uint64_t cycles) {
+  /* Multiply the two halves separately to avoid overflow. */
+  uint64_t hi = (cycles >> 32) * ns_mult;
+  uint64_t lo = (cycles & UINT32_MAX) * ns_mult;
+  return (hi << (32 - TSC_NS_SHIFT)) + (lo >> TSC_NS_SHIFT);
+}
+
+/* Converts NS nanoseconds to cycles of the TSC. */
+uint64_t tsc_from_ns(uint64_t ns) {
+  /* Split NS to avoid overflow. */
+  return ns / 1000000 * khz + ns % 1000000 * khz / 1000000;
+}
@@ -0,0 +1,21 @@
+#ifndef DEVICES_TSC_H
+#define DEVICES_TSC_H
+
+#include <stdint.h>
+
+/* Returns the current value of the time stamp counter. */
+static inline uint64_t tsc_read(void) {
+  uint64_t tsc;
+  asm volatile("rdtsc" : "=A"(tsc));
+  return tsc;
+}
+
+uint32_t tsc_calibrate(void);
+void tsc_set_khz(uint32_t khz);
+uint32_t tsc_khz(void);
+
+/* Conversions, which yield 0 until the TSC rate is known. */
+uint64_t tsc_to_ns(uint64_t cycles);
+uint64_t tsc_from_ns(uint64_t ns);
+
+#endif /* devices/tsc.h */
@@ -0,0 +1,118 @@
+#include "heap.h"
+#include "../debug.h"
+
+static void place(struct heap*, size_t index, struct heap_elem*);
+static void sift_up(struct heap*, size_t index);
+static void sift_down(struct heap*, size_t index);
+
+/* Initializes HEAP as an empty heap that stores up to CAPACITY
+   elements in SLOTS and orders them by LESS given auxiliary data
+   AUX. */
+void heap_init(struct heap* heap, struct heap_elem** slots, size_t capacity, heap_less_func* less,
+               void* aux) {
+  ASSERT(heap != NULL);
+  ASSERT(slots != NULL || capacity == 0);
+  ASSERT(less != NULL);
+
+  heap->slots = slots;
+  heap->elem_cnt = 0;
+  heap->capacity = capacity;
+  heap->less = less;
+  heap->aux = aux;
+}
+
+/* Inserts E into HEAP.  Returns true if successful, false if
+   HEAP is already full. */
+bool heap_push(struct heap* heap, struct heap_elem* e) {
+  ASSERT(e != NULL);
+
+  if (heap->elem_cnt >= heap->capacity)
+    return false;
+  place(heap, heap->elem_cnt++, e);
+  sift_up(heap, e->index);
+  return true;
+}
+
+/* Removes and returns the minimum element of HEAP, or a null
+   pointer if HEAP is empty. */
+struct heap_elem* heap_pop(struct heap* heap) {
+  struct heap_elem* min = heap_min(heap);
+  if (min != NULL)
+    heap_remove(heap, min);
+  return min;
+}
+
+/* Removes E from HEAP.  E must be an element of HEAP. */
+void heap_remove(struct heap* heap, struct heap_elem* e) {
+  size_t index = e->index;
+
+  ASSERT(index < heap->elem_cnt && heap->slots[index] == e);
+
+  struct heap_elem* last = heap->slots[--heap->elem_cnt];
+  if (last != e) {
+    place(heap, index, last);
+    heap_update(heap, last);
+  }
+}
+
+/* Restores E to its proper position in HEAP after the value it
+   compares by has changed in either direction. */
+void heap_update(struct heap* heap, struct heap_elem* e) {
+  ASSERT(e->index < heap->elem_cnt && heap->slots[e->index] == e);
+
+  sift_up(heap, e->index);
+  sift_down(heap, e->index);
+}
+
+/* Returns the minimum element of HEAP, or a null pointer if HEAP
+   is empty. */
+struct heap_elem* heap_min(const struct heap* heap) {
+  return heap->elem_cnt > 0 ? heap->slots[0] : NULL;
+}
+
+/* Returns the number of elements in HEAP. */
+size_t heap_size(const struct heap* heap) { return heap->elem_cnt; }
+
+/* Returns true if HEAP is empty, false otherwise. */
+bool heap_empty(const struct heap* heap) { return heap->elem_cnt == 0; }
+
+/* Stores E at position INDEX of HEAP. */
+static void place(struct heap* heap, size_t index, struct heap_elem* e) {
+  heap->slots[index] = e;
+  e->index = index;
+}
+
+/* Moves the element at INDEX toward the root of HEAP until its
+   parent is not greater than it. */
+static void sift_up(struct heap* heap, size_t index) {
+  struct heap_elem* e = heap->slots[index];
+
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (!heap->less(e, heap->slots[parent], heap->aux))
+      break;
+    place(heap, index, heap->slots[parent]);
+    index = parent;
+  }
+  place(heap, index, e);
+}
+
+/* Moves the element at INDEX away from the root of HEAP until
+   neither of its children is less than it. */
+static void sift_down(struct heap* heap, size_t index) {
+  struct heap_elem* e = heap->slots[index];
+
+  for (;;) {
+    size_t child = 2 * index + 1;
+    if (child >= heap->elem_cnt)
+      break;
+    if (child + 1 < heap->elem_cnt &&
+        heap->less(heap->slots[child + 1], heap->slots[child], heap->aux))
+      child++;
+    if (!heap->less(heap->slots[child], e, heap->aux))
+      break;
+    place(heap, index, heap->slots[child]);
+    index = child;
+  }
+  place(heap, index, e);
+}
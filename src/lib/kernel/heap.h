@@ -0,0 +1,59 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Binary min-heap.
+
+   The heap keeps pointers to its elements in a caller-supplied
+   array, so it never allocates memory and its capacity is fixed
+   when it is initialized.  Each structure that can be in a heap
+   must embed a struct heap_elem member, which records the
+   element's position in the array so that an arbitrary element
+   can be removed, or moved after its key changes, in O(log n).
+   heap_entry() converts a struct heap_elem back to the structure
+   that contains it, in the same way as list_entry(). */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+  size_t index; /* Position in the heap's slot array. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)                                                      \
+  ((STRUCT*)((uint8_t*)(HEAP_ELEM) - offsetof(STRUCT, MEMBER)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool heap_less_func(const struct heap_elem* a, const struct heap_elem* b, void* aux);
+
+/* Binary min-heap. */
+struct heap {
+  struct heap_elem** slots; /* Array of CAPACITY element pointers. */
+  size_t elem_cnt;          /* Number of elements in heap. */
+  size_t capacity;          /* Maximum number of elements. */
+  heap_less_func* less;     /* Comparison function. */
+  void* aux;                /* Auxiliary data for `less'. */
+};
+
+void heap_init(struct heap*, struct heap_elem** slots, size_t capacity, heap_less_func*,
+               void* aux);
+
+/* Insertion and removal. */
+bool heap_push(struct heap*, struct heap_elem*);
+struct heap_elem* heap_pop(struct heap*);
+void heap_remove(struct heap*, struct heap_elem*);
+void heap_update(struct heap*, struct heap_elem*);
+
+/* Information. */
+struct heap_elem* heap_min(const struct heap*);
+size_t heap_size(const struct heap*);
+bool heap_empty(const struct heap*);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,285 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* Our red-black tree follows [CLRS] chapter 13, with null
+   pointers standing in for the black sentinel leaves.  Because a
+   null leaf has no parent pointer, removal tracks the parent of
+   the node being fixed up explicitly. */
+
+static bool is_red(const struct rb_elem*);
+static void replace_child(struct rb_tree*, struct rb_elem* parent, struct rb_elem* old,
+                          struct rb_elem* new);
+static void rotate_left(struct rb_tree*, struct rb_elem*);
+static void rotate_right(struct rb_tree*, struct rb_elem*);
+static void insert_fixup(struct rb_tree*, struct rb_elem*);
+static void remove_fixup(struct rb_tree*, struct rb_elem*, struct rb_elem* parent);
+
+/* Initializes TREE as an empty tree ordered by LESS given
+   auxiliary data AUX. */
+void rb_init(struct rb_tree* tree, rb_less_func* less, void* aux) {
+  ASSERT(tree != NULL);
+  ASSERT(less != NULL);
+
+  tree->root = NULL;
+  tree->leftmost = NULL;
+  tree->elem_cnt = 0;
+  tree->less = less;
+  tree->aux = aux;
+}
+
+/* Inserts E into TREE after every element that is not greater
+   than it. */
+void rb_insert(struct rb_tree* tree, struct rb_elem* e) {
+  struct rb_elem* parent = NULL;
+  struct rb_elem** link = &tree->root;
+  bool leftmost = true;
+
+  ASSERT(e != NULL);
+
+  while (*link != NULL) {
+    parent = *link;
+    if (tree->less(e, parent, tree->aux))
+      link = &parent->left;
+    else {
+      link = &parent->right;
+      leftmost = false;
+    }
+  }
+
+  e->parent = parent;
+  e->left = e->right = NULL;
+  e->red = true;
+  *link = e;
+  if (leftmost)
+    tree->leftmost = e;
+  tree->elem_cnt++;
+
+  insert_fixup(tree, e);
+}
+
+/* Removes E from TREE.  E must be an element of TREE. */
+void rb_remove(struct rb_tree* tree, struct rb_elem* e) {
+  struct rb_elem *child, *parent;
+  bool removed_red;
+
+  ASSERT(e != NULL);
+  ASSERT(tree->elem_cnt > 0);
+
+  if (tree->leftmost == e)
+    tree->leftmost = rb_next(e);
+
+  if (e->left == NULL || e->right == NULL) {
+    /* E has at most one child, which takes its place. */
+    child = e->left != NULL ? e->left : e->right;
+    parent = e->parent;
+    removed_red = e->red;
+    if (child != NULL)
+      child->parent = parent;
+    replace_child(tree, parent, e, child);
+  } else {
+    /* E has two children.  Its successor S, which has no left
+       child, is spliced out of its own position and takes E's. */
+    struct rb_elem* s = e->right;
+    while (s->left != NULL)
+      s = s->left;
+
+    removed_red = s->red;
+    child = s->right;
+    if (s->parent == e)
+      parent = s;
+    else {
+      parent = s->parent;
+      if (child != NULL)
+        child->parent = parent;
+      parent->left = child;
+      s->right = e->right;
+      e->right->parent = s;
+    }
+    s->left = e->left;
+    e->left->parent = s;
+    s->parent = e->parent;
+    replace_child(tree, e->parent, e, s);
+    s->red = e->red;
+  }
+
+  tree->elem_cnt--;
+  if (!removed_red)
+    remove_fixup(tree, child, parent);
+}
+
+/* Returns the minimum element of TREE, or a null pointer if TREE
+   is empty.  Runs in O(1). */
+struct rb_elem* rb_min(const struct rb_tree* tree) { return tree->leftmost; }
+
+/* Returns the element that follows E in its tree, or a null
+   pointer if E is the maximum. */
+struct rb_elem* rb_next(const struct rb_elem* e) {
+  ASSERT(e != NULL);
+
+  if (e->right != NULL) {
+    e = e->right;
+    while (e->left != NULL)
+      e = e->left;
+    return (struct rb_elem*)e;
+  }
+  while (e->parent != NULL && e == e->parent->right)
+    e = e->parent;
+  return e->parent;
+}
+
+/* Returns the number of elements in TREE. */
+size_t rb_size(const struct rb_tree* tree) { return tree->elem_cnt; }
+
+/* Returns true if TREE is empty, false otherwise. */
+bool rb_empty(const struct rb_tree* tree) { return tree->root == NULL; }
+
+/* Returns true if E is a red node.  Null leaves are black. */
+static bool is_red(const struct rb_elem* e) { return e != NULL && e->red; }
+
+/* Makes NEW take OLD's place as a child of PARENT, or as the root
+   of TREE if PARENT is null. */
+static void replace_child(struct rb_tree* tree, struct rb_elem* parent, struct rb_elem* old,
+                          struct rb_elem* new) {
+  if (parent == NULL)
+    tree->root = new;
+  else if (parent->left == old)
+    parent->left = new;
+  else
+    parent->right = new;
+}
+
+/* Rotates the subtree rooted at X to the left, so that X's right
+   child takes X's place. */
+static void rotate_left(struct rb_tree* tree, struct rb_elem* x) {
+  struct rb_elem* y = x->right;
+
+  x->right = y->left;
+  if (y->left != NULL)
+    y->left->parent = x;
+  y->parent = x->parent;
+  replace_child(tree, x->parent, x, y);
+  y->left = x;
+  x->parent = y;
+}
+
+/* Rotates the subtree rooted at X to the right, so that X's left
+   child takes X's place. */
+static void rotate_right(struct rb_tree* tree, struct rb_elem* x) {
+  struct rb_elem* y = x->left;
+
+  x->left = y->right;
+  if (y->right != NULL)
+    y->right->parent = x;
+  y->parent = x->parent;
+  replace_child(tree, x->parent, x, y);
+  y->right = x;
+  x->parent = y;
+}
+
+/* Restores the red-black properties after inserting red node E. */
+static void insert_fixup(struct rb_tree* tree, struct rb_elem* e) {
+  struct rb_elem* p;
+
+  while ((p = e->parent) != NULL && p->red) {
+    /* P is red, so it is not the root and has a parent G. */
+    struct rb_elem* g = p->parent;
+
+    if (p == g->left) {
+      struct rb_elem* uncle = g->right;
+      if (is_red(uncle)) {
+        p->red = uncle->red = false;
+        g->red = true;
+        e = g;
+      } else {
+        if (e == p->right) {
+          rotate_left(tree, p);
+          e = p;
+          p = e->parent;
+        }
+        p->red = false;
+        g->red = true;
+        rotate_right(tree, g);
+      }
+    } else {
+      struct rb_elem* uncle = g->left;
+      if (is_red(uncle)) {
+        p->red = uncle->red = false;
+        g->red = true;
+        e = g;
+      } else {
+        if (e == p->left) {
+          rotate_right(tree, p);
+          e = p;
+          p = e->parent;
+        }
+        p->red = false;
+        g->red = true;
+        rotate_left(tree, g);
+      }
+    }
+  }
+  tree->root->red = false;
+}
+
+/* Restores the red-black properties after removing a black node
+   whose place was taken by X, possibly a null leaf, beneath
+   PARENT. */
+static void remove_fixup(struct rb_tree* tree, struct rb_elem* x, struct rb_elem* parent) {
+  while (x != tree->root && !is_red(x)) {
+    /* X carries an extra black, so its sibling W cannot be a null
+       leaf. */
+    if (x == parent->left) {
+      struct rb_elem* w = parent->right;
+      if (is_red(w)) {
+        w->red = false;
+        parent->red = true;
+        rotate_left(tree, parent);
+        w = parent->right;
+      }
+      if (!is_red(w->left) && !is_red(w->right)) {
+        w->red = true;
+        x = parent;
+        parent = x->parent;
+      } else {
+        if (!is_red(w->right)) {
+          w->left->red = false;
+          w->red = true;
+          rotate_right(tree, w);
+          w = parent->right;
+        }
+        w->red = parent->red;
+        parent->red = false;
+        w->right->red = false;
+        rotate_left(tree, parent);
+        x = tree->root;
+      }
+    } else {
+      struct rb_elem* w = parent->left;
+      if (is_red(w)) {
+        w->red = false;
+        parent->red = true;
+        rotate_right(tree, parent);
+        w = parent->left;
+      }
+      if (!is_red(w->left) && !is_red(w->right)) {
+        w->red = true;
+        x = parent;
+        parent = x->parent;
+      } else {
+        if (!is_red(w->left)) {
+          w->right->red = false;
+          w->red = true;
+          rotate_left(tree, w);
+          w = parent->left;
+        }
+        w->red = parent->red;
+        parent->red = false;
+        w->left->red = false;
+        rotate_right(tree, parent);
+        x = tree->root;
+      }
+    }
+  }
+  if (x != NULL)
+    x->red = false;
+}
@@ -22,12 +22,12 @@ enum {
   SYS_PT_CREATE,    /* Creates a new thread */
   SYS_PT_EXIT,      /* Exits the current thread */
   SYS_PT_JOIN,      /* Waits for thread to finish */
-  SYS_LOCK_INIT,    /* Initializes a lock */
-  SYS_LOCK_ACQUIRE, /* Acquires a lock */
-  SYS_LOCK_RELEASE, /* Releases a lock */
-  SYS_SEMA_INIT,    /* Initializes a semaphore */
-  SYS_SEMA_DOWN,    /* Downs a semaphore */
-  SYS_SEMA_UP,      /* Ups a semaphore */
+  SYS_LOCK_INIT,    /* Reserved; user locks now use futexes */
+  SYS_LOCK_ACQUIRE, /* Reserved */
+  SYS_LOCK_RELEASE, /* Reserved */
+  SYS_SEMA_INIT,    /* Reserved; user semaphores now use futexes */
+  SYS_SEMA_DOWN,    /* Reserved */
+  SYS_SEMA_UP,      /* Reserved */
   SYS_GET_TID,      /* Gets TID of the current thread */
 
   /* Project 3 and optionally project 4. */
@@ -39,7 +39,15 @@ enum {
   SYS_MKDIR,   /* Create a directory. */
   SYS_READDIR, /* Reads a directory entry. */
   SYS_ISDIR,   /* Tests if a fd represents a directory. */
-  SYS_INUMBER  /* Returns the inode number for a fd. */
+  SYS_INUMBER, /* Returns the inode number for a fd. */
+
+  /* Later additions, appended so that the numbers above stay
+     fixed. */
+  SYS_FUTEX_WAIT,   /* Sleeps on a user word */
+  SYS_FUTEX_WAKE,   /* Wakes threads sleeping on a user word */
+  SYS_SET_DEADLINE, /* Sets the current thread's period and runtime */
+  SYS_DL_YIELD,     /* Yields until the current thread's next period */
+  SYS_FORK          /* Duplicate the current process. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,19 @@
+#ifndef __LIB_TCB_H
+#define __LIB_TCB_H
+
+/* User thread control block.
+
+   The kernel builds one of these at the top of each user
+   thread's stack, with the thread's thread-local storage just
+   below it, and points the thread's %gs segment at it.  This is
+   the i386 ELF TLS layout ("variant II"): the thread pointer,
+   %gs:0, holds the control block's own address, and TLS
+   variables sit at negative offsets from it.  User code reads
+   the rest of the control block through %gs as well, so finding
+   out which thread is running takes no system call. */
+struct tcb {
+  struct tcb* self; /* This control block's address. */
+  int tid;          /* Thread identifier. */
+};
+
+#endif /* lib/tcb.h */
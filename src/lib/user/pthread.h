@@ -3,6 +3,7 @@
 
 #include <debug.h>
 #include <stdbool.h>
+#include <synch.h>
 
 /* Thread identifiers and thread function */
 typedef void (*pthread_fun)(void*);
@@ -14,4 +15,39 @@ tid_t pthread_create(pthread_fun fun, void* arg);
 void pthread_exit(void) NO_RETURN;
 bool pthread_join(tid_t);
 
+/* Condition variable, used with a lock_t. */
+typedef struct {
+  int seq;     /* Futex word, advanced by signals and broadcasts. */
+  int waiters; /* Threads in pthread_cond_wait(). */
+} pthread_cond_t;
+
+/* Barrier for a fixed number of threads. */
+typedef struct {
+  int count;   /* Threads per round. */
+  int arrived; /* Threads that have reached the current round. */
+  int round;   /* Futex word, advanced as each round completes. */
+} pthread_barrier_t;
+
+/* Reader-writer lock.  Readers are preferred: a writer waits
+   until no reader holds the lock. */
+typedef struct {
+  int state;   /* Number of readers, or -1 if held by a writer. */
+  int seq;     /* Futex word, advanced by releases with waiters. */
+  int waiters; /* Threads waiting to acquire the lock. */
+} pthread_rwlock_t;
+
+/* Implemented in synch.c. */
+bool pthread_cond_init(pthread_cond_t*);
+void pthread_cond_wait(pthread_cond_t*, lock_t*);
+void pthread_cond_signal(pthread_cond_t*);
+void pthread_cond_broadcast(pthread_cond_t*);
+
+bool pthread_barrier_init(pthread_barrier_t*, int count);
+bool pthread_barrier_wait(pthread_barrier_t*);
+
+bool pthread_rwlock_init(pthread_rwlock_t*);
+void pthread_rwlock_rdlock(pthread_rwlock_t*);
+void pthread_rwlock_wrlock(pthread_rwlock_t*);
+void pthread_rwlock_unlock(pthread_rwlock_t*);
+
 #endif /* lib/user/pthread.h */
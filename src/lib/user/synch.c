@@ -0,0 +1,286 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <syscall.h>
+
+/* User-level locks, semaphores, condition variables, barriers,
+   and reader-writer locks.
+
+   All of them keep their state in user memory and are taken and
+   released with atomic instructions, so that a thread only traps
+   into the kernel when it has to sleep, through futex_wait(), or
+   when it has to wake a sleeper, through futex_wake().
+
+   A lock's state word is LOCK_FREE, LOCK_HELD, or
+   LOCK_CONTENDED, the last meaning that it is held and threads
+   may be sleeping on it, so that release only needs to trap in
+   that case.  A semaphore's futex word is its value, and it
+   counts the threads that are sleeping on it so that up only
+   traps when there are any.  Condition variables, barriers, and
+   reader-writer locks sleep on a sequence number that is advanced
+   whenever their waiters should look again, and wake every
+   sleeper with a single futex_wake() when all of them may go on.
+
+   The state values and the semaphore magic number let us catch
+   use of an uninitialized lock or semaphore, with high
+   probability, and exit(1) as the kernel-based implementation
+   did. */
+#define LOCK_FREE 0x4c4f4300 /* "LOC\0" */
+#define LOCK_HELD (LOCK_FREE + 1)
+#define LOCK_CONTENDED (LOCK_FREE + 2)
+#define SEMA_MAGIC 0x5345    /* "SE" */
+
+/* Atomically replaces *P by NEW if it equals OLD, and returns
+   its previous value. */
+static inline int cmpxchg(int* p, int old, int new) {
+  int prev;
+  asm volatile("lock cmpxchgl %2, %1" : "=a"(prev), "+m"(*p) : "r"(new), "0"(old) : "memory");
+  return prev;
+}
+
+/* Atomically replaces *P by NEW, and returns its previous
+   value. */
+static inline int xchg(int* p, int new) {
+  asm volatile("xchgl %0, %1" : "+r"(new), "+m"(*p) : : "memory");
+  return new;
+}
+
+/* Atomically adds DELTA to *P, and returns its previous value. */
+static inline int atomic_fetch_add(int* p, int delta) {
+  asm volatile("lock xaddl %0, %1" : "+r"(delta), "+m"(*p) : : "memory");
+  return delta;
+}
+
+/* Atomically adds DELTA to *P. */
+static inline void atomic_add(int* p, int delta) {
+  asm volatile("lock addl %1, %0" : "+m"(*p) : "ir"(delta) : "memory");
+}
+
+/* Atomically adds DELTA to the 16-bit word *P. */
+static inline void atomic_add_short(unsigned short* p, short delta) {
+  asm volatile("lock addw %1, %0" : "+m"(*p) : "ir"(delta) : "memory");
+}
+
+/* Returns a value that identifies the running thread, for
+   checking lock ownership.  get_tid() reads it from the thread
+   control block without a system call. */
+static unsigned self(void) { return get_tid(); }
+
+/* Returns true if STATE is a valid lock state. */
+static bool lock_state_valid(int state) { return state >= LOCK_FREE && state <= LOCK_CONTENDED; }
+
+/* Initializes LOCK.  Returns false if LOCK is a null pointer. */
+bool lock_init(lock_t* lock) {
+  if (lock == NULL)
+    return false;
+  lock->state = LOCK_FREE;
+  lock->owner = 0;
+  return true;
+}
+
+/* Acquires LOCK, sleeping until it is free if necessary.  Exits
+   the process if LOCK is not initialized or is already held by
+   the running thread. */
+void lock_acquire(lock_t* lock) {
+  int state = cmpxchg(&lock->state, LOCK_FREE, LOCK_HELD);
+
+  if (state != LOCK_FREE) {
+    if (!lock_state_valid(state) || lock->owner == self())
+      exit(1);
+
+    /* Mark the lock contended, so that its holder wakes us when
+       it releases it, and sleep until we get it.  We cannot tell
+       whether others are still sleeping once we do, so we keep
+       it marked contended. */
+    if (state != LOCK_CONTENDED)
+      state = xchg(&lock->state, LOCK_CONTENDED);
+    while (state != LOCK_FREE) {
+      futex_wait(&lock->state, LOCK_CONTENDED);
+      state = xchg(&lock->state, LOCK_CONTENDED);
+    }
+  }
+  lock->owner = self();
+}
+
+/* Releases LOCK, waking a thread that is sleeping on it, if any.
+   Exits the process unless the running thread holds LOCK. */
+void lock_release(lock_t* lock) {
+  if (!lock_state_valid(lock->state) || lock->state == LOCK_FREE || lock->owner != self())
+    exit(1);
+
+  lock->owner = 0;
+  if (xchg(&lock->state, LOCK_FREE) == LOCK_CONTENDED)
+    futex_wake(&lock->state, 1);
+}
+
+/* Initializes SEMA to VAL.  Returns false if SEMA is a null
+   pointer or VAL is negative. */
+bool sema_init(sema_t* sema, int val) {
+  if (sema == NULL || val < 0)
+    return false;
+  sema->value = val;
+  sema->waiters = 0;
+  sema->magic = SEMA_MAGIC;
+  return true;
+}
+
+/* Waits for SEMA's value to become positive and then atomically
+   decrements it.  Exits the process if SEMA is not initialized. */
+void sema_down(sema_t* sema) {
+  if (sema->magic != SEMA_MAGIC)
+    exit(1);
+
+  for (;;) {
+    int value = sema->value;
+    if (value > 0) {
+      if (cmpxchg(&sema->value, value, value - 1) == value)
+        return;
+    } else {
+      atomic_add_short(&sema->waiters, 1);
+      futex_wait(&sema->value, value);
+      atomic_add_short(&sema->waiters, -1);
+    }
+  }
+}
+
+/* Increments SEMA's value and wakes up one thread waiting for
+   it, if any.  Exits the process if SEMA is not initialized. */
+void sema_up(sema_t* sema) {
+  if (sema->magic != SEMA_MAGIC)
+    exit(1);
+
+  atomic_add(&sema->value, 1);
+  if (sema->waiters != 0)
+    futex_wake(&sema->value, 1);
+}
+
+/* Initializes COND.  Returns false if COND is a null pointer. */
+bool pthread_cond_init(pthread_cond_t* cond) {
+  if (cond == NULL)
+    return false;
+  cond->seq = 0;
+  cond->waiters = 0;
+  return true;
+}
+
+/* Atomically releases LOCK and waits for COND to be signaled,
+   then reacquires LOCK before returning.  The running thread
+   must hold LOCK.  Like a POSIX condition variable, COND may
+   wake its waiters spuriously, so callers should recheck the
+   condition they are waiting for in a loop. */
+void pthread_cond_wait(pthread_cond_t* cond, lock_t* lock) {
+  atomic_add(&cond->waiters, 1);
+  int seq = cond->seq;
+  lock_release(lock);
+  futex_wait(&cond->seq, seq);
+  atomic_add(&cond->waiters, -1);
+  lock_acquire(lock);
+}
+
+/* Wakes one thread waiting on COND, if any. */
+void pthread_cond_signal(pthread_cond_t* cond) {
+  if (cond->waiters != 0) {
+    atomic_add(&cond->seq, 1);
+    futex_wake(&cond->seq, 1);
+  }
+}
+
+/* Wakes every thread waiting on COND, with a single system call
+   if there are any. */
+void pthread_cond_broadcast(pthread_cond_t* cond) {
+  if (cond->waiters != 0) {
+    atomic_add(&cond->seq, 1);
+    futex_wake(&cond->seq, INT_MAX);
+  }
+}
+
+/* Initializes BARRIER for rounds of COUNT threads.  Returns false
+   if BARRIER is a null pointer or COUNT is not positive. */
+bool pthread_barrier_init(pthread_barrier_t* barrier, int count) {
+  if (barrier == NULL || count <= 0)
+    return false;
+  barrier->count = count;
+  barrier->arrived = 0;
+  barrier->round = 0;
+  return true;
+}
+
+/* Waits until BARRIER's count of threads have called this
+   function in the current round.  The last thread to arrive
+   starts the next round, wakes the others with a single system
+   call, and returns true; the others return false. */
+bool pthread_barrier_wait(pthread_barrier_t* barrier) {
+  int round = barrier->round;
+
+  if (atomic_fetch_add(&barrier->arrived, 1) == barrier->count - 1) {
+    /* No thread can arrive for the next round before the round
+       number changes, so resetting the count first is safe. */
+    barrier->arrived = 0;
+    atomic_add(&barrier->round, 1);
+    futex_wake(&barrier->round, INT_MAX);
+    return true;
+  }
+  while (barrier->round == round)
+    futex_wait(&barrier->round, round);
+  return false;
+}
+
+/* Initializes RWLOCK.  Returns false if RWLOCK is a null
+   pointer. */
+bool pthread_rwlock_init(pthread_rwlock_t* rwlock) {
+  if (rwlock == NULL)
+    return false;
+  rwlock->state = 0;
+  rwlock->seq = 0;
+  rwlock->waiters = 0;
+  return true;
+}
+
+/* Sleeps until RWLOCK is released, unless it has been released
+   since the caller found it unavailable.  A reader, for whom
+   WRITER is false, only cares about a writer's release. */
+static void rwlock_sleep(pthread_rwlock_t* rwlock, bool writer) {
+  atomic_add(&rwlock->waiters, 1);
+  int seq = rwlock->seq;
+  int state = rwlock->state;
+  if (writer ? state != 0 : state < 0)
+    futex_wait(&rwlock->seq, seq);
+  atomic_add(&rwlock->waiters, -1);
+}
+
+/* Acquires RWLOCK for reading, sleeping while a writer holds it. */
+void pthread_rwlock_rdlock(pthread_rwlock_t* rwlock) {
+  for (;;) {
+    int state = rwlock->state;
+    if (state >= 0) {
+      if (cmpxchg(&rwlock->state, state, state + 1) == state)
+        return;
+    } else
+      rwlock_sleep(rwlock, false);
+  }
+}
+
+/* Acquires RWLOCK for writing, sleeping while anyone holds it. */
+void pthread_rwlock_wrlock(pthread_rwlock_t* rwlock) {
+  while (cmpxchg(&rwlock->state, 0, -1) != 0)
+    rwlock_sleep(rwlock, true);
+}
+
+/* Releases RWLOCK, which the running thread holds for reading or
+   writing, and wakes every waiter if it is now free.  Exits the
+   process if RWLOCK is not held. */
+void pthread_rwlock_unlock(pthread_rwlock_t* rwlock) {
+  int state = rwlock->state;
+
+  if (state == 0)
+    exit(1);
+  if (state < 0)
+    xchg(&rwlock->state, 0);
+  else if (atomic_fetch_add(&rwlock->state, -1) != 1)
+    return;
+
+  if (rwlock->waiters != 0) {
+    atomic_add(&rwlock->seq, 1);
+    futex_wake(&rwlock->seq, INT_MAX);
+  }
+}
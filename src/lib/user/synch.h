@@ -0,0 +1,27 @@
+#ifndef __LIB_USER_SYNCH_H
+#define __LIB_USER_SYNCH_H
+
+#include <stdbool.h>
+
+/* User-level locks and semaphores, implemented in synch.c on top
+   of futex_wait() and futex_wake().  Only the functions below
+   should touch their members. */
+typedef struct {
+  int state;      /* Futex word, LOCK_* in synch.c. */
+  unsigned owner; /* Holder, while held. */
+} lock_t;
+
+typedef struct {
+  int value;              /* Futex word, the semaphore's value. */
+  unsigned short waiters; /* Threads in futex_wait(). */
+  unsigned short magic;   /* SEMA_MAGIC once initialized. */
+} sema_t;
+
+bool lock_init(lock_t* lock);
+void lock_acquire(lock_t* lock);
+void lock_release(lock_t* lock);
+bool sema_init(sema_t* sema, int val);
+void sema_down(sema_t* sema);
+void sema_up(sema_t* sema);
+
+#endif /* lib/user/synch.h */
@@ -1,6 +1,8 @@
 #include <syscall.h>
 #include "../syscall-nr.h"
 #include <pthread.h>
+#include <stddef.h>
+#include <tcb.h>
 
 /* Invokes syscall NUMBER, passing no arguments, and returns the
    return value as an `int'. */
@@ -106,6 +108,8 @@ mapid_t mmap(int fd, void* addr) { return syscall2(SYS_MMAP, fd, addr); }
 
 void munmap(mapid_t mapid) { syscall1(SYS_MUNMAP, mapid); }
 
+pid_t fork(void) { return (pid_t)syscall0(SYS_FORK); }
+
 bool chdir(const char* dir) { return syscall1(SYS_CHDIR, dir); }
 
 bool mkdir(const char* dir) { return syscall1(SYS_MKDIR, dir); }
@@ -129,32 +133,19 @@ void sys_pthread_exit() {
 
 tid_t sys_pthread_join(tid_t tid) { return syscall1(SYS_PT_JOIN, tid); }
 
-bool lock_init(lock_t* lock) { return syscall1(SYS_LOCK_INIT, lock); }
-
-void lock_acquire(lock_t* lock) {
-  bool success = syscall1(SYS_LOCK_ACQUIRE, lock);
-  if (!success)
-    exit(1);
-}
-
-void lock_release(lock_t* lock) {
-  bool success = syscall1(SYS_LOCK_RELEASE, lock);
-  if (!success)
-    exit(1);
-}
+int futex_wait(int* addr, int val) { return syscall2(SYS_FUTEX_WAIT, addr, val); }
 
-bool sema_init(sema_t* sema, int val) { return syscall2(SYS_SEMA_INIT, sema, val); }
+int futex_wake(int* addr, int cnt) { return syscall2(SYS_FUTEX_WAKE, addr, cnt); }
 
-void sema_down(sema_t* sema) {
-  bool success = syscall1(SYS_SEMA_DOWN, sema);
-  if (!success)
-    exit(1);
+/* Returns the running thread's TID.  It comes from the thread
+   control block that %gs points to, so unlike the other calls
+   here it does not trap into the kernel. */
+tid_t get_tid(void) {
+  tid_t tid;
+  asm("movl %%gs:%c1, %0" : "=r"(tid) : "i"(offsetof(struct tcb, tid)));
+  return tid;
 }
 
-void sema_up(sema_t* sema) {
-  bool success = syscall1(SYS_SEMA_UP, sema);
-  if (!success)
-    exit(1);
-}
+bool set_deadline(int period, int runtime) { return syscall2(SYS_SET_DEADLINE, period, runtime); }
 
-tid_t get_tid(void) { return syscall0(SYS_GET_TID); }
+void deadline_yield(void) { syscall0(SYS_DL_YIELD); }
@@ -4,15 +4,12 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <pthread.h>
+#include <synch.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t)-1)
 
-/* Synchronization Types */
-typedef char lock_t;
-typedef char sema_t;
-
 /* Map region identifier. */
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t)-1)
@@ -43,17 +40,16 @@ double compute_e(int n);
 tid_t sys_pthread_create(stub_fun sfun, pthread_fun tfun, const void* arg);
 void sys_pthread_exit(void) NO_RETURN;
 tid_t sys_pthread_join(tid_t tid);
-bool lock_init(lock_t* lock);
-void lock_acquire(lock_t* lock);
-void lock_release(lock_t* lock);
-bool sema_init(sema_t* sema, int val);
-void sema_down(sema_t* sema);
-void sema_up(sema_t* sema);
+int futex_wait(int* addr, int val);
+int futex_wake(int* addr, int cnt);
 tid_t get_tid(void);
+bool set_deadline(int period, int runtime);
+void deadline_yield(void);
 
 /* Project 3 and optionally project 4. */
 mapid_t mmap(int fd, void* addr);
 void munmap(mapid_t);
+pid_t fork(void);
 
 /* Project 4 only. */
 bool chdir(const char* dir);
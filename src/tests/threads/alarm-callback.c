@@ -0,0 +1,87 @@
+/* Tests the timer_add() and timer_cancel() callback API.
+
+   Arms timers due in the past, within the wheel's first level,
+   and several levels out, plus one that is canceled and one that
+   rearms itself from its own callback, then checks that each
+   fired exactly once at its expiry tick, or not at all if
+   canceled. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define TIMER_CNT 5
+
+struct test_timer {
+  struct timer timer;
+  int64_t delay;    /* Ticks after the start to expire. */
+  int64_t fired_at; /* Tick of the last call, or -1. */
+  int fire_cnt;     /* Number of calls. */
+};
+
+static struct test_timer timers[TIMER_CNT];
+static struct test_timer rearming;
+static int64_t start;
+
+static void record_fire(void* tt_) {
+  struct test_timer* tt = tt_;
+  tt->fired_at = timer_ticks();
+  tt->fire_cnt++;
+}
+
+static void rearm_fire(void* tt_) {
+  struct test_timer* tt = tt_;
+  record_fire(tt);
+  if (tt->fire_cnt < 3)
+    timer_add(&tt->timer, tt->fired_at + tt->delay);
+}
+
+void test_alarm_callback(void) {
+  static const int64_t delays[TIMER_CNT] = {-5, 1, 63, 64, 4100};
+
+  for (int i = 0; i < TIMER_CNT; i++) {
+    timers[i].delay = delays[i];
+    timers[i].fired_at = -1;
+    timers[i].fire_cnt = 0;
+    timer_setup(&timers[i].timer, record_fire, &timers[i]);
+  }
+  rearming.delay = 10;
+  rearming.fired_at = -1;
+  rearming.fire_cnt = 0;
+  timer_setup(&rearming.timer, rearm_fire, &rearming);
+
+  /* Arm everything atomically so that all delays count from the
+     same tick. */
+  enum intr_level old_level = intr_disable();
+  start = timer_ticks();
+  for (int i = 0; i < TIMER_CNT; i++)
+    timer_add(&timers[i].timer, start + timers[i].delay);
+  timer_add(&rearming.timer, start + rearming.delay);
+  intr_set_level(old_level);
+
+  msg("Canceling timer due after %lld ticks: %s", timers[2].delay,
+      timer_cancel(&timers[2].timer) ? "was pending" : "not pending");
+
+  timer_sleep(timers[TIMER_CNT - 1].delay + 1);
+
+  for (int i = 0; i < TIMER_CNT; i++) {
+    int64_t expected = timers[i].delay > 0 ? start + timers[i].delay : start + 1;
+    if (i == 2)
+      msg("Timer due after %lld ticks fired %d times.", timers[i].delay, timers[i].fire_cnt);
+    else if (timers[i].fire_cnt == 1 && timers[i].fired_at == expected)
+      msg("Timer due after %lld ticks fired once, on time.", timers[i].delay);
+    else
+      fail("timer due after %lld ticks fired %d times, last %lld ticks after start",
+           timers[i].delay, timers[i].fire_cnt, timers[i].fired_at - start);
+  }
+
+  if (rearming.fire_cnt == 3 && rearming.fired_at == start + 3 * rearming.delay)
+    msg("Rearming timer fired 3 times, on time.");
+  else
+    fail("rearming timer fired %d times, last %lld ticks after start", rearming.fire_cnt,
+         rearming.fired_at - start);
+  msg("Canceling an expired timer: %s",
+      timer_cancel(&timers[1].timer) ? "was pending" : "not pending");
+}
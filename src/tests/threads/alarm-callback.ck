@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-callback) begin
+(alarm-callback) Canceling timer due after 63 ticks: was pending
+(alarm-callback) Timer due after -5 ticks fired once, on time.
+(alarm-callback) Timer due after 1 ticks fired once, on time.
+(alarm-callback) Timer due after 63 ticks fired 0 times.
+(alarm-callback) Timer due after 64 ticks fired once, on time.
+(alarm-callback) Timer due after 4100 ticks fired once, on time.
+(alarm-callback) Rearming timer fired 3 times, on time.
+(alarm-callback) Canceling an expired timer: not pending
+(alarm-callback) end
+EOF
+pass;
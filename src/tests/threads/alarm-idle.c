@@ -0,0 +1,64 @@
+/* Checks that timers stay on time while the tick is stopped.
+
+   Runs with "-tickless", so while the main thread sleeps the idle
+   thread stops the periodic tick between timers.  Arms timers
+   that expire one tick apart, a few ticks apart, further apart
+   than one tickless stretch can cover, and on a boundary where
+   the wheel cascades, then checks that each fired exactly on its
+   expiry tick and that the tick count afterward is right. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define TIMER_CNT 7
+
+struct test_timer {
+  struct timer timer;
+  int64_t delay;    /* Ticks after the start to expire. */
+  int64_t fired_at; /* Tick of the call, or -1. */
+};
+
+static struct test_timer timers[TIMER_CNT];
+
+static void record_fire(void* tt_) {
+  struct test_timer* tt = tt_;
+  tt->fired_at = timer_ticks();
+}
+
+void test_alarm_idle(void) {
+  static const int64_t delays[TIMER_CNT] = {1, 2, 5, 9, 23, 128, 300};
+  int64_t start;
+
+  ASSERT(timer_tickless);
+
+  for (int i = 0; i < TIMER_CNT; i++) {
+    timers[i].delay = delays[i];
+    timers[i].fired_at = -1;
+    timer_setup(&timers[i].timer, record_fire, &timers[i]);
+  }
+
+  enum intr_level old_level = intr_disable();
+  start = timer_ticks();
+  for (int i = 0; i < TIMER_CNT; i++)
+    timer_add(&timers[i].timer, start + timers[i].delay);
+  intr_set_level(old_level);
+
+  msg("Sleeping while %d timers expire...", TIMER_CNT);
+  timer_sleep(start + delays[TIMER_CNT - 1] + 10 - timer_ticks());
+
+  for (int i = 0; i < TIMER_CNT; i++) {
+    if (timers[i].fired_at == start + timers[i].delay)
+      msg("Timer due after %lld ticks fired on time.", timers[i].delay);
+    else
+      fail("timer due after %lld ticks fired %lld ticks after start", timers[i].delay,
+           timers[i].fired_at - start);
+  }
+
+  int64_t elapsed = timer_elapsed(start);
+  if (elapsed != delays[TIMER_CNT - 1] + 10)
+    fail("slept for %lld ticks, expected %lld", elapsed, delays[TIMER_CNT - 1] + 10);
+  msg("Woke up on time.");
+}
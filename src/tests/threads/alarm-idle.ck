@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-idle) begin
+(alarm-idle) Sleeping while 7 timers expire...
+(alarm-idle) Timer due after 1 ticks fired on time.
+(alarm-idle) Timer due after 2 ticks fired on time.
+(alarm-idle) Timer due after 5 ticks fired on time.
+(alarm-idle) Timer due after 9 ticks fired on time.
+(alarm-idle) Timer due after 23 ticks fired on time.
+(alarm-idle) Timer due after 128 ticks fired on time.
+(alarm-idle) Timer due after 300 ticks fired on time.
+(alarm-idle) Woke up on time.
+(alarm-idle) end
+EOF
+pass;
@@ -0,0 +1,59 @@
+/* Checks the nanosecond clock and the delays built on it.
+
+   timer_now_ns() must never go backward, must agree with the
+   timer tick to within NS_TOLERANCE percent over SLEEP_TICKS
+   ticks, and busy waits and sub-tick sleeps must last at least
+   as long as requested. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define READ_CNT 1000
+#define SLEEP_TICKS 20
+#define NS_TOLERANCE 10
+#define DELAY_US 2000
+#define SLEEP_US 1500
+
+void test_alarm_ns(void) {
+  uint64_t prev, start, elapsed, expected;
+  int64_t tick;
+
+  prev = timer_now_ns();
+  for (int i = 0; i < READ_CNT; i++) {
+    uint64_t now = timer_now_ns();
+    if (now < prev)
+      fail("clock went backward from %llu ns to %llu ns", prev, now);
+    prev = now;
+  }
+  msg("Clock never went backward.");
+
+  /* Start on a tick boundary. */
+  tick = timer_ticks();
+  while (timer_ticks() == tick)
+    barrier();
+  start = timer_now_ns();
+  timer_sleep(SLEEP_TICKS);
+  elapsed = timer_now_ns() - start;
+  expected = (uint64_t)SLEEP_TICKS * (NSEC_PER_SEC / TIMER_FREQ);
+  if (elapsed * 100 < expected * (100 - NS_TOLERANCE) ||
+      elapsed * 100 > expected * (100 + NS_TOLERANCE))
+    fail("%d ticks took %llu ns, expected about %llu ns", SLEEP_TICKS, elapsed, expected);
+  msg("Clock agrees with the timer tick.");
+
+  start = timer_now_ns();
+  timer_udelay(DELAY_US);
+  elapsed = timer_now_ns() - start;
+  if (elapsed < DELAY_US * 1000ULL)
+    fail("%d us delay took only %llu ns", DELAY_US, elapsed);
+  msg("Delay lasted long enough.");
+
+  start = timer_now_ns();
+  timer_usleep(SLEEP_US);
+  elapsed = timer_now_ns() - start;
+  if (elapsed < SLEEP_US * 1000ULL)
+    fail("%d us sleep took only %llu ns", SLEEP_US, elapsed);
+  msg("Sleep lasted long enough.");
+}
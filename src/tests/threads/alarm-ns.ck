@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-ns) begin
+(alarm-ns) Clock never went backward.
+(alarm-ns) Clock agrees with the timer tick.
+(alarm-ns) Delay lasted long enough.
+(alarm-ns) Sleep lasted long enough.
+(alarm-ns) end
+EOF
+pass;
@@ -0,0 +1,59 @@
+/* Measures thread creation throughput, with and without the
+   thread page cache.
+
+   The main thread repeatedly creates a thread that exits at
+   once and waits for it to finish, and reports the average time
+   stamp counter cycles per thread over THREAD_CNT threads, along
+   with the rate that works out to at the calibrated TSC rate.
+   Each thread's page is retired when it exits, so after the first
+   few iterations every thread_create() should reuse a cached
+   page instead of getting a fresh one from the page allocator.
+   The second run drains the cache after every thread, so that
+   each thread_create() gets its page from the allocator and each
+   page goes back to it, as they did before the cache. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/tsc.h"
+
+#define THREAD_CNT 5000
+
+static thread_func exit_thread;
+
+/* Creates THREAD_CNT threads one after another, draining the
+   thread page cache after each if DRAIN is true, and reports the
+   cost per thread under the name WHAT. */
+static void measure(const char* what, bool drain) {
+  struct semaphore done_sema;
+  uint64_t start_tsc;
+
+  sema_init(&done_sema, 0);
+  thread_page_cache_drain();
+  start_tsc = tsc_read();
+  for (int i = 0; i < THREAD_CNT; i++) {
+    if (thread_create("exiter", PRI_DEFAULT, exit_thread, &done_sema) == TID_ERROR)
+      fail("could not create thread %d", i);
+    sema_down(&done_sema);
+    if (drain)
+      thread_page_cache_drain();
+  }
+  uint64_t elapsed = tsc_read() - start_tsc;
+  long long cycles = elapsed / THREAD_CNT;
+  uint64_t ns = tsc_to_ns(elapsed);
+
+  msg("%d threads %s: %lld cycles per thread", THREAD_CNT, what, cycles);
+  msg("%d threads %s: %lld threads per second", THREAD_CNT, what,
+      (long long)(THREAD_CNT * 1000000000ULL / (ns > 0 ? ns : 1)));
+}
+
+void test_create_overhead(void) {
+  measure("with the page cache", false);
+  measure("without the page cache", true);
+}
+
+static void exit_thread(void* done_sema_) {
+  struct semaphore* done_sema = done_sema_;
+  sema_up(done_sema);
+}
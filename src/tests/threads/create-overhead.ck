@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "missing begin message" unless grep ($_ eq "(create-overhead) begin", @output);
+fail "missing end message" unless grep ($_ eq "(create-overhead) end", @output);
+foreach my $cache ("with the page cache", "without the page cache") {
+    foreach my $unit ("cycles per thread", "threads per second") {
+        fail "missing measurement of $unit $cache"
+          unless grep (/^\(create-overhead\) 5000 threads $cache: \d+ $unit$/, @output);
+    }
+}
+pass;
@@ -0,0 +1,41 @@
+/* Checks that thread_set_deadline() rejects bad parameters and
+   admits deadline threads only while their total utilization
+   stays at or below 1. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func try_deadline_thread;
+
+static struct semaphore done_sema;
+static bool admitted;
+
+/* Has a new thread request 1 tick in every 100 and returns
+   whether it was admitted. */
+static bool child_admitted(void) {
+  thread_create("child", PRI_DEFAULT, try_deadline_thread, NULL);
+  sema_down(&done_sema);
+  return admitted;
+}
+
+void test_edf_admission(void) {
+  ASSERT(active_sched_policy == SCHED_EDF);
+
+  sema_init(&done_sema, 0);
+
+  msg("Runtime 0 rejected: %s", thread_set_deadline(10, 0) ? "no" : "yes");
+  msg("Runtime above period rejected: %s", thread_set_deadline(10, 11) ? "no" : "yes");
+  msg("Utilization 1/2 admitted: %s", thread_set_deadline(10, 5) ? "yes" : "no");
+  msg("Raising own utilization to 1 admitted: %s", thread_set_deadline(10, 10) ? "yes" : "no");
+  msg("Child admitted while full: %s", child_admitted() ? "yes" : "no");
+  msg("Clearing own deadline succeeded: %s", thread_set_deadline(0, 0) ? "yes" : "no");
+  msg("Child admitted after clearing: %s", child_admitted() ? "yes" : "no");
+}
+
+static void try_deadline_thread(void* aux UNUSED) {
+  admitted = thread_set_deadline(100, 1);
+  sema_up(&done_sema);
+}
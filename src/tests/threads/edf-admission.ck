@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-admission) begin
+(edf-admission) Runtime 0 rejected: yes
+(edf-admission) Runtime above period rejected: yes
+(edf-admission) Utilization 1/2 admitted: yes
+(edf-admission) Raising own utilization to 1 admitted: yes
+(edf-admission) Child admitted while full: no
+(edf-admission) Clearing own deadline succeeded: yes
+(edf-admission) Child admitted after clearing: yes
+(edf-admission) end
+EOF
+pass;
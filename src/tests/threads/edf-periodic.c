@@ -0,0 +1,107 @@
+/* Checks that periodic deadline threads meet every deadline
+   while higher-priority threads keep the CPU busy.
+
+   Two deadline threads created at PRI_MIN run for a fixed number
+   of ticks in each of their periods and then give up the rest of
+   their budget.  Meanwhile greedy threads at PRI_MAX - 1 spin,
+   so under strict priority alone the deadline threads would
+   never run at all.  Each deadline thread must start and finish
+   its work inside every period, allowing one tick of slack for
+   its first period starting slightly before it reads the
+   clock. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define GREEDY_CNT 4
+#define PERIOD_CNT 20
+
+/* Parameters of a periodic deadline thread. */
+struct periodic {
+  int id;
+  int64_t period;  /* Period, in ticks. */
+  int64_t runtime; /* Reserved budget per period, in ticks. */
+  int64_t work;    /* Ticks actually spent per period. */
+};
+
+static thread_func periodic_thread;
+static thread_func greedy_thread;
+
+static struct semaphore start_sema;
+static struct semaphore done_sema;
+static bool keep_spinning;
+
+void test_edf_periodic(void) {
+  static struct periodic periodics[] = {{0, 10, 3, 2}, {1, 15, 4, 3}};
+  const int periodic_cnt = sizeof periodics / sizeof *periodics;
+
+  ASSERT(active_sched_policy == SCHED_EDF);
+
+  thread_set_priority(PRI_MAX);
+  sema_init(&start_sema, 0);
+  sema_init(&done_sema, 0);
+  keep_spinning = true;
+
+  for (int i = 0; i < GREEDY_CNT; i++)
+    thread_create("greedy", PRI_MAX - 1, greedy_thread, NULL);
+  for (int i = 0; i < periodic_cnt; i++)
+    thread_create("periodic", PRI_MIN, periodic_thread, &periodics[i]);
+
+  msg("Running %d deadline threads against %d greedy threads...", periodic_cnt, GREEDY_CNT);
+  for (int i = 0; i < GREEDY_CNT + periodic_cnt; i++)
+    sema_up(&start_sema);
+  for (int i = 0; i < periodic_cnt; i++)
+    sema_down(&done_sema);
+
+  enum intr_level old_level = intr_disable();
+  keep_spinning = false;
+  intr_set_level(old_level);
+  for (int i = 0; i < GREEDY_CNT; i++)
+    sema_down(&done_sema);
+}
+
+static void periodic_thread(void* p_) {
+  struct periodic* p = p_;
+
+  sema_down(&start_sema);
+
+  int64_t release = timer_ticks();
+  if (!thread_set_deadline(p->period, p->runtime))
+    fail("deadline thread %d was not admitted", p->id);
+
+  for (int i = 0; i < PERIOD_CNT; i++) {
+    int64_t deadline = release + p->period + 1;
+    int64_t start = timer_ticks();
+    if (start >= deadline)
+      fail("deadline thread %d first ran %lld ticks into period %d", p->id, start - release, i);
+    while (timer_ticks() < start + p->work)
+      continue;
+    if (timer_ticks() > deadline)
+      fail("deadline thread %d missed deadline %d by %lld ticks", p->id, i,
+           timer_ticks() - deadline);
+
+    release += p->period;
+    thread_deadline_yield();
+  }
+
+  msg("Deadline thread %d met %d deadlines.", p->id, PERIOD_CNT);
+  thread_set_deadline(0, 0);
+  sema_up(&done_sema);
+}
+
+static void greedy_thread(void* aux UNUSED) {
+  bool spin = true;
+
+  sema_down(&start_sema);
+  while (spin) {
+    enum intr_level old_level = intr_disable();
+    spin = keep_spinning;
+    intr_set_level(old_level);
+  }
+  sema_up(&done_sema);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-periodic) begin
+(edf-periodic) Running 2 deadline threads against 4 greedy threads...
+(edf-periodic) Deadline thread 0 met 20 deadlines.
+(edf-periodic) Deadline thread 1 met 20 deadlines.
+(edf-periodic) end
+EOF
+pass;
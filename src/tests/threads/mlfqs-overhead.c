@@ -0,0 +1,110 @@
+/* Measures the cost of the scheduler's per-tick bookkeeping
+   under SCHED_MLFQS with 10, 100, and 500 blocked threads in the
+   system.
+
+   The main thread first times a busy loop with interrupts off,
+   then runs the same loop with interrupts on for a few seconds.
+   Every cycle that the time stamp counter advanced beyond what
+   the loop itself accounts for went to the timer interrupt,
+   thread_tick(), and any resulting context switches, so dividing
+   the difference by the elapsed ticks gives the overhead per
+   tick, which is also reported in nanoseconds.  The blocked
+   threads never run, so a scheduler that only touches the
+   running thread each tick should report roughly the same figure
+   at every thread count. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "devices/tsc.h"
+
+/* Busy-loop iterations between clock reads. */
+#define CHUNK_LOOPS 1000
+
+/* Chunks to time with interrupts off. */
+#define CALIBRATE_CHUNKS 2000
+
+/* Seconds to time with interrupts on.  Spans several load_avg
+   updates and recent_cpu sweeps. */
+#define MEASURE_SECONDS 3
+
+static thread_func blocked_thread;
+static void test_mlfqs_overhead(size_t thread_cnt);
+
+#define TEST(n)                                                                                    \
+  void test_mlfqs_overhead_##n(void) { test_mlfqs_overhead(n); }
+
+TEST(10);
+TEST(100);
+TEST(500);
+
+static struct semaphore release_sema;
+static struct semaphore done_sema;
+
+/* Spins for LOOPS iterations.  NO_INLINE for the same reason as
+   busy_wait() in devices/timer.c. */
+static void NO_INLINE spin(int loops) {
+  while (loops-- > 0)
+    barrier();
+}
+
+static void test_mlfqs_overhead(size_t thread_cnt) {
+  uint64_t start_tsc, cycles, chunk_cycles, loop_cycles;
+  int64_t start, ticks;
+  long long chunks;
+  long long overhead;
+  enum intr_level old_level;
+
+  ASSERT(active_sched_policy == SCHED_MLFQS);
+
+  sema_init(&release_sema, 0);
+  sema_init(&done_sema, 0);
+  for (size_t i = 0; i < thread_cnt; i++)
+    if (thread_create("blocked", PRI_DEFAULT, blocked_thread, NULL) == TID_ERROR)
+      fail("could not create thread %zu", i);
+
+  /* Time the loop with no interrupts to disturb it. */
+  old_level = intr_disable();
+  start = timer_ticks();
+  start_tsc = tsc_read();
+  for (int i = 0; i < CALIBRATE_CHUNKS; i++) {
+    spin(CHUNK_LOOPS);
+    timer_elapsed(start);
+  }
+  chunk_cycles = (tsc_read() - start_tsc) / CALIBRATE_CHUNKS;
+  intr_set_level(old_level);
+
+  /* Start on a tick boundary, then run the same loop with the
+     timer interrupt enabled. */
+  start = timer_ticks();
+  while (timer_ticks() == start)
+    barrier();
+  start = timer_ticks();
+  start_tsc = tsc_read();
+  chunks = 0;
+  while (timer_elapsed(start) < MEASURE_SECONDS * TIMER_FREQ) {
+    spin(CHUNK_LOOPS);
+    chunks++;
+  }
+  cycles = tsc_read() - start_tsc;
+  ticks = timer_elapsed(start);
+
+  loop_cycles = chunks * chunk_cycles;
+  overhead = cycles > loop_cycles ? (long long)((cycles - loop_cycles) / ticks) : 0;
+  msg("%zu blocked threads: %lld cycles, %llu ns of scheduler overhead per tick", thread_cnt,
+      overhead, tsc_to_ns(overhead));
+
+  for (size_t i = 0; i < thread_cnt; i++)
+    sema_up(&release_sema);
+  for (size_t i = 0; i < thread_cnt; i++)
+    sema_down(&done_sema);
+}
+
+static void blocked_thread(void* aux UNUSED) {
+  sema_down(&release_sema);
+  sema_up(&done_sema);
+}
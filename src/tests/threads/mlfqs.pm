@@ -143,4 +143,20 @@ sub mlfqs_row {
     printf "%6s %8s %3s %-8s %s\n", @_;
 }
 
+sub check_mlfqs_overhead {
+    my ($thread_cnt) = @_;
+    our ($test);
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+
+    my ($name) = "mlfqs-overhead-$thread_cnt";
+    fail "missing begin message" unless grep ($_ eq "($name) begin", @output);
+    fail "missing end message" unless grep ($_ eq "($name) end", @output);
+    fail "missing overhead measurement"
+      unless grep (/^\($name\) $thread_cnt blocked threads: \d+ cycles, \d+ ns of scheduler overhead per tick$/,
+		   @output);
+    pass;
+}
+
 1;
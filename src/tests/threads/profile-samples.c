@@ -0,0 +1,22 @@
+/* Runs with "-profile" and spins for SPIN_TICKS timer ticks with
+   interrupts on, so that the profiler takes a sample on each.
+   profile-samples.ck checks the samples printed at shutdown. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/profile.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
+
+#define SPIN_TICKS 50
+
+void test_profile_samples(void) {
+  int64_t start = timer_ticks();
+
+  ASSERT(profile_enabled);
+
+  msg("Spinning for %d ticks...", SPIN_TICKS);
+  while (timer_elapsed(start) < SPIN_TICKS)
+    barrier();
+  msg("Done spinning.");
+}
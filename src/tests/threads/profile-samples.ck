@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+my (@core) = get_core_output ("run", @output);
+
+fail "missing begin message" unless grep ($_ eq "(profile-samples) begin", @core);
+fail "missing end message" unless grep ($_ eq "(profile-samples) end", @core);
+
+# Check the profile, which is printed after the test's output.
+my ($samples);
+my ($counted) = 0;
+foreach (@output) {
+    $samples = $1 if /^Profile: (\d+) samples, \d+ dropped$/;
+    $counted += $1 if /^P 0x[0-9a-f]{8} \d+ (\d+)$/;
+}
+fail "missing profile" if !defined $samples;
+fail "only $samples samples taken while spinning for 50 ticks" if $samples < 50;
+fail "profile lists $counted of $samples samples" if $counted > $samples || $counted == 0;
+pass;
@@ -0,0 +1,155 @@
+/* Exercises lib/kernel/rbtree.c, which the fair scheduler, the
+   priority donation trees and the semaphore wait queues all
+   build on.
+
+   Trees of every size up to MAX_SIZE are built from shuffled
+   keys, half of their elements are removed in random order and
+   then put back.  After every insertion and removal the tree must
+   still be a valid red-black tree: ordered, with a black root, no
+   red node with a red child, the same number of black nodes on
+   every path, consistent parent pointers, an accurate size, and
+   rb_min() returning the leftmost element.  Elements with equal
+   keys must come out in insertion order. */
+
+#include <random.h>
+#include <rbtree.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+
+/* Largest tree to test. */
+#define MAX_SIZE 64
+
+/* Number of distinct keys, so that larger trees hold duplicates. */
+#define KEY_CNT 40
+
+/* A tree element. */
+struct value {
+  struct rb_elem elem; /* Tree element. */
+  int key;             /* Sort key. */
+  int seq;             /* Insertion sequence number. */
+};
+
+static void shuffle(struct value**, size_t);
+static bool value_less(const struct rb_elem*, const struct rb_elem*, void*);
+static void insert(struct rb_tree*, struct value*);
+static void verify(const struct rb_tree*, size_t size);
+static int black_height(const struct rb_elem*, const struct rb_elem* parent);
+
+static int next_seq;
+
+void test_rbtree(void) {
+  static struct value values[MAX_SIZE];
+  static struct value* order[MAX_SIZE];
+
+  random_init(0);
+  for (size_t size = 0; size <= MAX_SIZE; size++) {
+    for (int repeat = 0; repeat < 10; repeat++) {
+      struct rb_tree tree;
+
+      rb_init(&tree, value_less, NULL);
+      for (size_t i = 0; i < size; i++) {
+        values[i].key = i % KEY_CNT;
+        order[i] = &values[i];
+      }
+      shuffle(order, size);
+
+      /* Insert everything. */
+      for (size_t i = 0; i < size; i++) {
+        insert(&tree, order[i]);
+        verify(&tree, i + 1);
+      }
+
+      /* Remove half in random order, then put it back. */
+      shuffle(order, size);
+      for (size_t i = 0; i < size / 2; i++) {
+        rb_remove(&tree, &order[i]->elem);
+        verify(&tree, size - i - 1);
+      }
+      for (size_t i = 0; i < size / 2; i++) {
+        insert(&tree, order[i]);
+        verify(&tree, size - size / 2 + i + 1);
+      }
+
+      /* Drain the tree from its minimum, the way the scheduler
+         does. */
+      for (size_t i = 0; i < size; i++) {
+        rb_remove(&tree, rb_min(&tree));
+        verify(&tree, size - i - 1);
+      }
+    }
+  }
+  msg("Insertion and removal kept the tree balanced and ordered.");
+}
+
+/* Shuffles the CNT elements of ARRAY into random order. */
+static void shuffle(struct value** array, size_t cnt) {
+  for (size_t i = 0; i < cnt; i++) {
+    size_t j = i + random_ulong() % (cnt - i);
+    struct value* t = array[j];
+    array[j] = array[i];
+    array[i] = t;
+  }
+}
+
+/* Returns true if value A's key is less than value B's. */
+static bool value_less(const struct rb_elem* a_, const struct rb_elem* b_, void* aux UNUSED) {
+  const struct value* a = rb_entry(a_, struct value, elem);
+  const struct value* b = rb_entry(b_, struct value, elem);
+
+  return a->key < b->key;
+}
+
+/* Inserts V into TREE, stamping it with the next sequence
+   number. */
+static void insert(struct rb_tree* tree, struct value* v) {
+  v->seq = next_seq++;
+  rb_insert(tree, &v->elem);
+}
+
+/* Fails unless TREE is a valid red-black tree of SIZE elements. */
+static void verify(const struct rb_tree* tree, size_t size) {
+  if (rb_size(tree) != size)
+    fail("tree reports %zu elements, expected %zu", rb_size(tree), size);
+  if (rb_empty(tree) != (size == 0))
+    fail("rb_empty() is wrong for a tree of %zu elements", size);
+  if (tree->root != NULL && (tree->root->parent != NULL || tree->root->red))
+    fail("root is red or has a parent");
+  black_height(tree->root, NULL);
+
+  /* An in-order walk must visit SIZE elements in order, starting
+     from the leftmost one, and break ties by insertion order. */
+  const struct rb_elem* leftmost = tree->root;
+  while (leftmost != NULL && leftmost->left != NULL)
+    leftmost = leftmost->left;
+  if (rb_min(tree) != leftmost)
+    fail("rb_min() is not the leftmost element");
+
+  size_t cnt = 0;
+  const struct value* prev = NULL;
+  for (struct rb_elem* e = rb_min(tree); e != NULL; e = rb_next(e)) {
+    const struct value* v = rb_entry(e, struct value, elem);
+    if (prev != NULL && (prev->key > v->key || (prev->key == v->key && prev->seq > v->seq)))
+      fail("elements %d/%d and %d/%d are out of order", prev->key, prev->seq, v->key, v->seq);
+    prev = v;
+    cnt++;
+  }
+  if (cnt != size)
+    fail("in-order walk visited %zu elements, expected %zu", cnt, size);
+}
+
+/* Checks the subtree rooted at E, whose parent must be PARENT,
+   and returns its black height. */
+static int black_height(const struct rb_elem* e, const struct rb_elem* parent) {
+  if (e == NULL)
+    return 1;
+  if (e->parent != parent)
+    fail("node's parent pointer is wrong");
+  if (e->red && ((e->left != NULL && e->left->red) || (e->right != NULL && e->right->red)))
+    fail("red node has a red child");
+
+  int left = black_height(e->left, e);
+  int right = black_height(e->right, e);
+  if (left != right)
+    fail("black heights %d and %d differ", left, right);
+  return left + !e->red;
+}
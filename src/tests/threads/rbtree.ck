@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rbtree) begin
+(rbtree) Insertion and removal kept the tree balanced and ordered.
+(rbtree) end
+EOF
+pass;
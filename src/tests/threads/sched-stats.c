@@ -0,0 +1,102 @@
+/* Checks the scheduler's latency and run-time accounting.
+
+   A sleeper thread blocks in timer_sleep() SLEEP_CNT times while
+   two yielder threads call thread_yield() YIELD_CNT times each,
+   handing the CPU back and forth.  Each thread then takes a copy
+   of its own statistics.  The sleeper must have been switched
+   out voluntarily at least once per sleep, and the yielders
+   involuntarily for most of their yields.  Every thread must
+   have one time slice per switch away from it and one run-queue
+   wait per dispatch, and the system-wide statistics must cover
+   at least what the threads recorded. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEP_CNT 10
+#define YIELD_CNT 20
+#define THREAD_CNT 3
+
+static thread_func sleeper_thread;
+static thread_func yielder_thread;
+
+static struct semaphore done_sema;
+static struct sched_stats results[THREAD_CNT];
+
+static void check_hist(const char* name, const struct sched_hist*, uint32_t samples);
+
+void test_sched_stats(void) {
+  struct sched_stats sys;
+  uint32_t voluntary = 0, involuntary = 0;
+  int i;
+
+  sema_init(&done_sema, 0);
+  thread_create("sleeper", PRI_DEFAULT, sleeper_thread, &results[0]);
+  thread_create("yielder 1", PRI_DEFAULT, yielder_thread, &results[1]);
+  thread_create("yielder 2", PRI_DEFAULT, yielder_thread, &results[2]);
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down(&done_sema);
+
+  if (results[0].voluntary < SLEEP_CNT)
+    fail("sleeper blocked %u times but recorded %u voluntary switches", SLEEP_CNT,
+         results[0].voluntary);
+  msg("Sleeper recorded its voluntary switches.");
+
+  for (i = 1; i < THREAD_CNT; i++)
+    if (results[i].involuntary < YIELD_CNT / 2)
+      fail("yielder %d yielded %d times but recorded %u involuntary switches", i, YIELD_CNT,
+           results[i].involuntary);
+  msg("Yielders recorded their involuntary switches.");
+
+  for (i = 0; i < THREAD_CNT; i++) {
+    uint32_t switches = results[i].voluntary + results[i].involuntary;
+    check_hist("slice", &results[i].slice, switches);
+    check_hist("wait", &results[i].wait, switches + 1);
+    voluntary += results[i].voluntary;
+    involuntary += results[i].involuntary;
+  }
+  msg("Every thread has one slice per switch and one wait per dispatch.");
+
+  schedstat_get(&sys);
+  if (sys.voluntary < voluntary || sys.involuntary < involuntary)
+    fail("system-wide statistics miss some of the threads' switches");
+  check_hist("system slice", &sys.slice, sys.slice.samples);
+  check_hist("system wait", &sys.wait, sys.wait.samples);
+  msg("System-wide statistics cover every thread.");
+}
+
+/* Fails unless histogram H, named NAME, holds SAMPLES samples
+   spread over its buckets. */
+static void check_hist(const char* name, const struct sched_hist* h, uint32_t samples) {
+  uint32_t sum = 0;
+  int i;
+
+  for (i = 0; i < SCHED_HIST_BUCKETS; i++)
+    sum += h->cnt[i];
+  if (h->samples != samples || sum != samples)
+    fail("%s histogram has %u samples in %u bucket entries, expected %u", name, h->samples, sum,
+         samples);
+}
+
+/* Takes a copy of the running thread's statistics in STATS. */
+static void save_stats(struct sched_stats* stats) {
+  if (!schedstat_get_thread(stats))
+    fail("thread has no scheduler statistics");
+}
+
+static void sleeper_thread(void* stats) {
+  for (int i = 0; i < SLEEP_CNT; i++)
+    timer_sleep(1);
+  save_stats(stats);
+  sema_up(&done_sema);
+}
+
+static void yielder_thread(void* stats) {
+  for (int i = 0; i < YIELD_CNT; i++)
+    thread_yield();
+  save_stats(stats);
+  sema_up(&done_sema);
+}
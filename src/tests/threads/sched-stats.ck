@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-stats) begin
+(sched-stats) Sleeper recorded its voluntary switches.
+(sched-stats) Yielders recorded their involuntary switches.
+(sched-stats) Every thread has one slice per switch and one wait per dispatch.
+(sched-stats) System-wide statistics cover every thread.
+(sched-stats) end
+EOF
+pass;
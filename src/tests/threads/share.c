@@ -0,0 +1,81 @@
+/* Harness for tests that check how a proportional-share
+   scheduler divides the CPU.
+
+   Each counter thread counts as fast as it can for SHARE_SECONDS
+   seconds, while the main thread sleeps.  Then each thread's
+   fraction of the total count must be within SHARE_TOLERANCE
+   tenths of a percent of its weight's fraction of the total
+   weight. */
+
+#include "tests/threads/share.h"
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func counter_thread;
+
+static struct semaphore start_sema;
+static struct semaphore done_sema;
+static bool keep_counting;
+
+/* Runs the CNT threads described by COUNTERS against each other
+   and fails unless each got its share of the CPU. */
+void share_run(struct share_counter* counters, size_t cnt) {
+  int total_weight = 0;
+  int64_t total_count = 0;
+  size_t i;
+
+  sema_init(&start_sema, 0);
+  sema_init(&done_sema, 0);
+  keep_counting = true;
+
+  /* Threads inherit their creator's tickets. */
+  int main_tickets = thread_get_tickets();
+  for (i = 0; i < cnt; i++) {
+    counters[i].count = 0;
+    if (counters[i].tickets != 0)
+      thread_set_tickets(counters[i].tickets);
+    thread_create("counter", counters[i].priority, counter_thread, &counters[i].count);
+    thread_set_tickets(main_tickets);
+    total_weight += counters[i].weight;
+  }
+
+  msg("Starting %zu counter threads for %d seconds...", cnt, SHARE_SECONDS);
+  for (i = 0; i < cnt; i++)
+    sema_up(&start_sema);
+  timer_sleep(SHARE_SECONDS * TIMER_FREQ);
+
+  enum intr_level old_level = intr_disable();
+  keep_counting = false;
+  intr_set_level(old_level);
+  for (i = 0; i < cnt; i++)
+    sema_down(&done_sema);
+
+  for (i = 0; i < cnt; i++)
+    total_count += counters[i].count;
+  for (i = 0; i < cnt; i++) {
+    int expected = counters[i].weight * 1000 / total_weight;
+    int actual = counters[i].count * 1000 / total_count;
+    if (actual < expected - SHARE_TOLERANCE || actual > expected + SHARE_TOLERANCE)
+      fail("thread %s got %d.%d%% of the CPU, expected %d.%d%%", counters[i].name, actual / 10,
+           actual % 10, expected / 10, expected % 10);
+    msg("Thread %s got its share of the CPU.", counters[i].name);
+  }
+}
+
+static void counter_thread(void* counter_) {
+  int64_t* counter = counter_;
+  bool loop = true;
+
+  sema_down(&start_sema);
+  while (loop) {
+    enum intr_level old_level = intr_disable();
+    *counter += 1;
+    loop = keep_counting;
+    intr_set_level(old_level);
+  }
+  sema_up(&done_sema);
+}
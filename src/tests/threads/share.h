@@ -0,0 +1,25 @@
+#ifndef TESTS_THREADS_SHARE_H
+#define TESTS_THREADS_SHARE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* How long the counter threads run, in seconds. */
+#define SHARE_SECONDS 10
+
+/* Allowed deviation from a thread's expected share, in tenths of
+   a percent of the CPU. */
+#define SHARE_TOLERANCE 20
+
+/* A thread competing for the CPU in share_run(). */
+struct share_counter {
+  const char* name; /* Description for messages, e.g. "with 100 tickets". */
+  int priority;     /* Priority to create the thread at. */
+  int tickets;      /* Stride tickets to give it, or 0 for the default. */
+  int weight;       /* Its expected share, relative to the others. */
+  int64_t count;    /* How far it counted, set by share_run(). */
+};
+
+void share_run(struct share_counter*, size_t cnt);
+
+#endif /* tests/threads/share.h */
@@ -0,0 +1,25 @@
+/* Checks that the fair scheduler divides the CPU among competing
+   threads in proportion to the weights of their priorities.
+
+   Three threads at priorities 31, 38 and 45 count as fast as they
+   can for 10 seconds.  Weights grow by 10% per priority level, so
+   each should end up with its weight's share of the total count,
+   give or take SHARE_TOLERANCE tenths of a percent. */
+
+#include "tests/threads/share.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+void test_smfs_share(void) {
+  /* Weights are round(1024 * 1.1**(priority - 31)). */
+  static struct share_counter counters[] = {
+      {"at priority 31", 31, 0, 1024, 0},
+      {"at priority 38", 38, 0, 1995, 0},
+      {"at priority 45", 45, 0, 3889, 0},
+  };
+
+  ASSERT(active_sched_policy == SCHED_FAIR);
+
+  share_run(counters, sizeof counters / sizeof *counters);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(smfs-share) begin
+(smfs-share) Starting 3 counter threads for 10 seconds...
+(smfs-share) Thread at priority 31 got its share of the CPU.
+(smfs-share) Thread at priority 38 got its share of the CPU.
+(smfs-share) Thread at priority 45 got its share of the CPU.
+(smfs-share) end
+EOF
+pass;
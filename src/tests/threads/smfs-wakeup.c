@@ -0,0 +1,111 @@
+/* Checks that the fair scheduler places a thread that wakes from
+   a long sleep near min_vruntime.
+
+   GREEDY_CNT threads count as fast as they can while a sleeper
+   sleeps for SLEEP_TICKS, long enough for them to get far ahead
+   of its old vruntime.  On waking, the sleeper must run within
+   MAX_LATENCY ticks, so it is not starved behind the greedy
+   threads.  It then counts for WINDOW_TICKS itself, and must get
+   about its fair 1 / (GREEDY_CNT + 1) share of that window
+   rather than using its old vruntime to monopolise the CPU. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define GREEDY_CNT 3
+#define SLEEP_TICKS 200
+#define WINDOW_TICKS 200
+
+/* Longest acceptable delay between the sleeper's wakeup time and
+   its first run, in ticks. */
+#define MAX_LATENCY 8
+
+/* Allowed range of the sleeper's share of the window, in
+   percent.  Its fair share is 25%. */
+#define MIN_SHARE 15
+#define MAX_SHARE 40
+
+static thread_func greedy_thread;
+static thread_func sleeper_thread;
+
+static struct semaphore wake_sema;
+static struct semaphore done_sema;
+static bool keep_counting;
+static bool sleeper_counting;
+static int64_t greedy_count;
+static int64_t sleeper_count;
+static int64_t wakeup_latency;
+
+void test_smfs_wakeup(void) {
+  ASSERT(active_sched_policy == SCHED_FAIR);
+
+  sema_init(&wake_sema, 0);
+  sema_init(&done_sema, 0);
+  keep_counting = sleeper_counting = true;
+  greedy_count = sleeper_count = 0;
+
+  msg("Starting %d greedy threads and a sleeper...", GREEDY_CNT);
+  for (int i = 0; i < GREEDY_CNT; i++)
+    thread_create("greedy", PRI_DEFAULT, greedy_thread, NULL);
+  thread_create("sleeper", PRI_DEFAULT, sleeper_thread, NULL);
+
+  /* Once the sleeper wakes, let it count alongside the greedy
+     threads for WINDOW_TICKS. */
+  sema_down(&wake_sema);
+  enum intr_level old_level = intr_disable();
+  int64_t greedy_start = greedy_count;
+  intr_set_level(old_level);
+  timer_sleep(WINDOW_TICKS);
+  old_level = intr_disable();
+  sleeper_counting = false;
+  int64_t window_greedy_count = greedy_count - greedy_start;
+  keep_counting = false;
+  intr_set_level(old_level);
+  for (int i = 0; i < GREEDY_CNT + 1; i++)
+    sema_down(&done_sema);
+
+  if (wakeup_latency > MAX_LATENCY)
+    fail("sleeper ran %lld ticks after waking, expected at most %d", wakeup_latency,
+         MAX_LATENCY);
+  msg("Sleeper ran promptly after waking.");
+
+  int share = sleeper_count * 100 / (sleeper_count + window_greedy_count);
+  if (share < MIN_SHARE || share > MAX_SHARE)
+    fail("sleeper got %d%% of the CPU after waking, expected %d%% to %d%%", share, MIN_SHARE,
+         MAX_SHARE);
+  msg("Sleeper got its share of the CPU after waking.");
+}
+
+static void greedy_thread(void* aux UNUSED) {
+  bool loop = true;
+
+  while (loop) {
+    enum intr_level old_level = intr_disable();
+    greedy_count++;
+    loop = keep_counting;
+    intr_set_level(old_level);
+  }
+  sema_up(&done_sema);
+}
+
+static void sleeper_thread(void* aux UNUSED) {
+  bool loop = true;
+
+  int64_t wake_time = timer_ticks() + SLEEP_TICKS;
+  timer_sleep(SLEEP_TICKS);
+  wakeup_latency = timer_ticks() - wake_time;
+  sema_up(&wake_sema);
+
+  while (loop) {
+    enum intr_level old_level = intr_disable();
+    sleeper_count++;
+    loop = sleeper_counting;
+    intr_set_level(old_level);
+  }
+  sema_up(&done_sema);
+}
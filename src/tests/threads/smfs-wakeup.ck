@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(smfs-wakeup) begin
+(smfs-wakeup) Starting 3 greedy threads and a sleeper...
+(smfs-wakeup) Sleeper ran promptly after waking.
+(smfs-wakeup) Sleeper got its share of the CPU after waking.
+(smfs-wakeup) end
+EOF
+pass;
@@ -0,0 +1,25 @@
+/* Checks that the stride scheduler divides the CPU among
+   competing threads in proportion to their tickets.
+
+   Four threads holding 100, 200, 300, and 400 tickets count as
+   fast as they can for 10 seconds.  Each should end up with its
+   ticket share of the total count, give or take SHARE_TOLERANCE
+   tenths of a percent. */
+
+#include "tests/threads/share.h"
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+
+void test_stride_share(void) {
+  static struct share_counter counters[] = {
+      {"with 100 tickets", PRI_DEFAULT, 100, 100, 0},
+      {"with 200 tickets", PRI_DEFAULT, 200, 200, 0},
+      {"with 300 tickets", PRI_DEFAULT, 300, 300, 0},
+      {"with 400 tickets", PRI_DEFAULT, 400, 400, 0},
+  };
+
+  ASSERT(active_sched_policy == SCHED_STRIDE);
+
+  share_run(counters, sizeof counters / sizeof *counters);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(stride-share) begin
+(stride-share) Starting 4 counter threads for 10 seconds...
+(stride-share) Thread with 100 tickets got its share of the CPU.
+(stride-share) Thread with 200 tickets got its share of the CPU.
+(stride-share) Thread with 300 tickets got its share of the CPU.
+(stride-share) Thread with 400 tickets got its share of the CPU.
+(stride-share) end
+EOF
+pass;
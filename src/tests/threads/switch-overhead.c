@@ -0,0 +1,119 @@
+/* Measures the cost of a context switch with lazy FPU switching.
+
+   The main thread and a partner ping-pong through a pair of
+   semaphores, first without touching the FPU and then with each
+   of them using it between switches, and reports the average
+   time stamp counter cycles per switch.  Threads that leave the
+   FPU alone should not pay for it at all, while threads that
+   both use it pay for a #NM trap and a save and restore on every
+   switch.  For comparison, the test also times the FSAVE and
+   FRSTOR pair that switching the FPU eagerly would cost on every
+   switch.  Each figure is also given in nanoseconds.
+
+   The cycle counts vary from run to run, so what the test checks
+   is the number of #NM traps behind them: none at all while
+   neither thread uses the FPU, which is where the FSAVE and
+   FRSTOR pair is saved, and one per switch while both do. */
+
+#include <float.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/fpu.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/tsc.h"
+
+/* Round trips, of two switches each, per measurement. */
+#define ROUND_TRIPS 5000
+
+static thread_func partner_thread;
+
+static struct semaphore ping_sema;
+static struct semaphore pong_sema;
+static struct semaphore done_sema;
+static bool use_fpu;
+
+/* Returns the average cycles per context switch between the
+   main thread and a partner, using the FPU between switches if
+   FPU is true, and stores the number of #NM traps taken during
+   the switches in *TRAPS. */
+static long long measure_switches(bool fpu, long long* traps) {
+  uint64_t start_tsc;
+  long long start_traps;
+
+  use_fpu = fpu;
+  sema_init(&ping_sema, 0);
+  sema_init(&pong_sema, 0);
+  sema_init(&done_sema, 0);
+  thread_create("partner", PRI_DEFAULT, partner_thread, NULL);
+
+  /* Let the partner start and block first. */
+  sema_up(&ping_sema);
+  sema_down(&pong_sema);
+
+  start_traps = fpu_trap_count();
+  start_tsc = tsc_read();
+  for (int i = 0; i < ROUND_TRIPS; i++) {
+    if (use_fpu)
+      fpu_push(i);
+    sema_up(&ping_sema);
+    sema_down(&pong_sema);
+    if (use_fpu && fpu_pop() != i)
+      fail("FPU state was not preserved across a switch");
+  }
+  long long cycles = (tsc_read() - start_tsc) / (2 * ROUND_TRIPS);
+  *traps = fpu_trap_count() - start_traps;
+
+  sema_up(&ping_sema);
+  sema_down(&done_sema);
+  return cycles;
+}
+
+void test_switch_overhead(void) {
+  struct fpu_state state;
+  uint64_t start_tsc;
+  enum intr_level old_level;
+
+  /* Time what an eager switch does to the FPU. */
+  old_level = intr_disable();
+  asm volatile("fninit");
+  start_tsc = tsc_read();
+  for (int i = 0; i < ROUND_TRIPS; i++)
+    asm volatile("fnsave %0; frstor %0" : "+m"(state));
+  long long eager = (tsc_read() - start_tsc) / ROUND_TRIPS;
+  intr_set_level(old_level);
+
+  long long lazy_traps, fpu_traps;
+  long long lazy = measure_switches(false, &lazy_traps);
+  long long fpu = measure_switches(true, &fpu_traps);
+
+  if (lazy_traps != 0)
+    fail("%lld switches without FPU use took %lld FPU traps", 2LL * ROUND_TRIPS, lazy_traps);
+  msg("Switches without FPU use took no FPU traps.");
+
+  /* Whichever thread owned the FPU before the loop may skip its
+     first trap. */
+  if (fpu_traps < 2 * ROUND_TRIPS - 1 || fpu_traps > 2 * ROUND_TRIPS)
+    fail("%lld switches with FPU use took %lld FPU traps", 2LL * ROUND_TRIPS, fpu_traps);
+  msg("Switches with FPU use took one FPU trap each.");
+
+  msg("FSAVE and FRSTOR: %lld cycles, %llu ns", eager, tsc_to_ns(eager));
+  msg("Switch without FPU use: %lld cycles, %llu ns", lazy, tsc_to_ns(lazy));
+  msg("Switch with FPU use: %lld cycles, %llu ns", fpu, tsc_to_ns(fpu));
+}
+
+static void partner_thread(void* aux UNUSED) {
+  sema_down(&ping_sema);
+  sema_up(&pong_sema);
+  for (int i = 0; i < ROUND_TRIPS; i++) {
+    sema_down(&ping_sema);
+    if (use_fpu)
+      fpu_push(ROUND_TRIPS + i);
+    sema_up(&pong_sema);
+    if (use_fpu && fpu_pop() != ROUND_TRIPS + i)
+      fail("FPU state was not preserved across a switch");
+  }
+  sema_down(&ping_sema);
+  sema_up(&done_sema);
+}
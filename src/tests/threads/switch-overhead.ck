@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "missing begin message" unless grep ($_ eq "(switch-overhead) begin", @output);
+fail "missing end message" unless grep ($_ eq "(switch-overhead) end", @output);
+foreach my $check ("Switches without FPU use took no FPU traps.",
+                   "Switches with FPU use took one FPU trap each.") {
+    fail "missing \"$check\"" unless grep ($_ eq "(switch-overhead) $check", @output);
+}
+foreach my $what ("FSAVE and FRSTOR", "Switch without FPU use", "Switch with FPU use") {
+    fail "missing measurement for \"$what\""
+      unless grep (/^\(switch-overhead\) $what: \d+ cycles, \d+ ns$/, @output);
+}
+pass;
@@ -10,6 +10,8 @@ static const struct test threads_tests[] = {
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-callback", test_alarm_callback},
+    {"alarm-idle", test_alarm_idle},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -37,6 +39,9 @@ static const struct test threads_tests[] = {
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"mlfqs-overhead-10", test_mlfqs_overhead_10},
+    {"mlfqs-overhead-100", test_mlfqs_overhead_100},
+    {"mlfqs-overhead-500", test_mlfqs_overhead_500},
     {"smfs-starve-0", test_smfs_starve_0},
     {"smfs-starve-1", test_smfs_starve_1},
     {"smfs-starve-2", test_smfs_starve_2},
@@ -50,7 +55,19 @@ static const struct test threads_tests[] = {
     {"smfs-hierarchy-16", test_smfs_hierarchy_16},
     {"smfs-hierarchy-32", test_smfs_hierarchy_32},
     {"smfs-hierarchy-64", test_smfs_hierarchy_64},
-    {"smfs-hierarchy-256", test_smfs_hierarchy_256}};
+    {"smfs-hierarchy-256", test_smfs_hierarchy_256},
+    {"smfs-share", test_smfs_share},
+    {"smfs-wakeup", test_smfs_wakeup},
+    {"stride-share", test_stride_share},
+    {"edf-admission", test_edf_admission},
+    {"edf-periodic", test_edf_periodic},
+    {"switch-overhead", test_switch_overhead},
+    {"create-overhead", test_create_overhead},
+    {"sched-stats", test_sched_stats},
+    {"alarm-ns", test_alarm_ns},
+    {"trace-events", test_trace_events},
+    {"profile-samples", test_profile_samples},
+    {"rbtree", test_rbtree}};
 
 /* Runs the threads test named NAME. */
 void run_threads_test(const char* name) {
@@ -11,6 +11,8 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_callback;
+extern test_func test_alarm_idle;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -38,6 +40,9 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_mlfqs_overhead_10;
+extern test_func test_mlfqs_overhead_100;
+extern test_func test_mlfqs_overhead_500;
 extern test_func test_smfs_starve_0;
 extern test_func test_smfs_starve_1;
 extern test_func test_smfs_starve_2;
@@ -52,5 +57,17 @@ extern test_func test_smfs_hierarchy_16;
 extern test_func test_smfs_hierarchy_32;
 extern test_func test_smfs_hierarchy_64;
 extern test_func test_smfs_hierarchy_256;
+extern test_func test_smfs_share;
+extern test_func test_smfs_wakeup;
+extern test_func test_stride_share;
+extern test_func test_edf_admission;
+extern test_func test_edf_periodic;
+extern test_func test_switch_overhead;
+extern test_func test_create_overhead;
+extern test_func test_sched_stats;
+extern test_func test_alarm_ns;
+extern test_func test_trace_events;
+extern test_func test_profile_samples;
+extern test_func test_rbtree;
 
 #endif /* tests/threads/tests.h */
@@ -0,0 +1,41 @@
+/* Runs with "-trace" and makes the kernel produce each kind of
+   event that a threads kernel can: the main thread sleeps, which
+   blocks it, lets timer interrupts unblock it, and schedules
+   other threads, and then waits for a lock that a lower-priority
+   thread holds.  trace-events.ck checks the trace dumped at
+   shutdown. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/trace.h"
+#include "devices/timer.h"
+
+static thread_func holder_thread;
+
+static struct lock lock;
+static struct semaphore held_sema;
+
+void test_trace_events(void) {
+  ASSERT(trace_enabled);
+
+  lock_init(&lock);
+  sema_init(&held_sema, 0);
+  thread_create("holder", PRI_DEFAULT - 1, holder_thread, NULL);
+
+  /* Sleep, so that the holder gets the lock. */
+  timer_sleep(5);
+  sema_down(&held_sema);
+
+  lock_acquire(&lock);
+  msg("Acquired the lock.");
+  lock_release(&lock);
+}
+
+static void holder_thread(void* aux UNUSED) {
+  lock_acquire(&lock);
+  sema_up(&held_sema);
+  timer_sleep(20);
+  lock_release(&lock);
+}
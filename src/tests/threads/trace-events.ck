@@ -0,0 +1,27 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+my (@core) = get_core_output ("run", @output);
+
+fail "missing begin message" unless grep ($_ eq "(trace-events) begin", @core);
+fail "missing lock message" unless grep ($_ eq "(trace-events) Acquired the lock.", @core);
+fail "missing end message" unless grep ($_ eq "(trace-events) end", @core);
+
+# Check the trace, which is printed after the test's output.
+my ($records) = 0;
+my (%seen);
+foreach (@output) {
+    $records = $1 if /^Trace: (\d+) records, \d+ kHz TSC$/;
+    $seen{hex ($1)}++ if /^T [0-9a-f]{16} ([0-9a-f]{4}) [0-9a-f]{4} [0-9a-f]{8}$/;
+}
+fail "missing trace" if !$records;
+my (%names) = (0 => "schedule", 1 => "thread block", 2 => "thread unblock",
+	       3 => "interrupt entry", 4 => "interrupt exit", 10 => "lock contention");
+foreach my $event (sort { $a <=> $b } keys %names) {
+    fail "trace has no $names{$event} events" if !$seen{$event};
+}
+pass;
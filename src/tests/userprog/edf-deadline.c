@@ -0,0 +1,52 @@
+/* Drives the deadline system calls through the EDF scheduler:
+   set_deadline() must reject malformed reservations and any that
+   would overcommit the CPU, accept the rest, and deadline_yield()
+   must return once the next period begins. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <pthread.h>
+#include <syscall.h>
+
+static void reserve(void* arg);
+
+void test_main(void) {
+  /* Malformed reservations. */
+  if (set_deadline(-1, 1))
+    fail("accepted a negative period");
+  if (set_deadline(10, 0))
+    fail("accepted a zero runtime");
+  if (set_deadline(10, -1))
+    fail("accepted a negative runtime");
+  if (set_deadline(10, 11))
+    fail("accepted a runtime longer than its period");
+  msg("Malformed reservations rejected.");
+
+  if (!set_deadline(20, 12))
+    fail("rejected a 60%% reservation");
+  for (int i = 0; i < 3; i++)
+    deadline_yield();
+  msg("Yielded to the next period three times.");
+
+  /* A second thread may only take what is left. */
+  pthread_check_join(pthread_check_create(reserve, NULL));
+
+  /* Replacing our own reservation does not count it twice. */
+  if (!set_deadline(20, 20))
+    fail("rejected a 100%% reservation that replaces our own");
+  deadline_yield();
+  if (!set_deadline(0, 0))
+    fail("could not clear the reservation");
+  msg("Reservation replaced and cleared.");
+}
+
+/* Asks for more of the CPU than the main thread left free, then
+   for less. */
+static void reserve(void* arg UNUSED) {
+  if (set_deadline(20, 10))
+    fail("accepted a reservation that overcommits the CPU");
+  if (!set_deadline(20, 8))
+    fail("rejected a reservation that fits");
+  deadline_yield();
+  msg("Second thread admitted only within the free share.");
+}
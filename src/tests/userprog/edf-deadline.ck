@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_USER_FAULTS => 1, [<<'EOF']);
+(edf-deadline) begin
+(edf-deadline) Malformed reservations rejected.
+(edf-deadline) Yielded to the next period three times.
+(edf-deadline) Second thread admitted only within the free share.
+(edf-deadline) Reservation replaced and cleared.
+(edf-deadline) end
+edf-deadline: exit(0)
+EOF
+pass;
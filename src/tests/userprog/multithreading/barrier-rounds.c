@@ -0,0 +1,82 @@
+/* Measures a parallel computation in phases separated by
+   barriers.
+
+   NUM_THREADS threads, main among them, go through ROUNDS rounds.
+   In each round every thread publishes a value and waits at the
+   barrier, then checks every other thread's value and waits at
+   the barrier again before the next round may overwrite them.
+   Exactly one thread per barrier must be told it was the last to
+   arrive.  Main reports the average time stamp counter cycles per
+   barrier. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <stdint.h>
+#include <syscall.h>
+#include <pthread.h>
+
+#define NUM_THREADS 8
+#define ROUNDS 500
+
+pthread_barrier_t barrier;
+int values[NUM_THREADS];
+int serial_cnt[NUM_THREADS];
+int mismatches[NUM_THREADS];
+
+void thread_function(void* arg_);
+
+/* Returns the processor's time stamp counter. */
+static inline uint64_t rdtsc(void) {
+  uint64_t tsc;
+  asm volatile("rdtsc" : "=A"(tsc));
+  return tsc;
+}
+
+/* Runs every round as thread number SELF. */
+static void run_rounds(int self) {
+  for (int round = 1; round <= ROUNDS; round++) {
+    values[self] = round * NUM_THREADS + self;
+    serial_cnt[self] += pthread_barrier_wait(&barrier);
+
+    for (int i = 0; i < NUM_THREADS; i++)
+      if (values[i] != round * NUM_THREADS + i)
+        mismatches[self]++;
+    serial_cnt[self] += pthread_barrier_wait(&barrier);
+  }
+}
+
+void thread_function(void* arg_) { run_rounds(*(int*)arg_); }
+
+void test_main(void) {
+  static int ids[NUM_THREADS];
+  tid_t tids[NUM_THREADS];
+
+  if (!pthread_barrier_init(&barrier, NUM_THREADS))
+    fail("pthread_barrier_init() failed");
+  if (pthread_barrier_init(&barrier, 0))
+    fail("Initialized barrier for 0 threads");
+
+  for (int i = 1; i < NUM_THREADS; i++) {
+    ids[i] = i;
+    tids[i] = pthread_check_create(thread_function, &ids[i]);
+  }
+
+  uint64_t start = rdtsc();
+  run_rounds(0);
+  uint64_t cycles = rdtsc() - start;
+
+  for (int i = 1; i < NUM_THREADS; i++)
+    pthread_check_join(tids[i]);
+
+  int serial = 0, mismatch = 0;
+  for (int i = 0; i < NUM_THREADS; i++) {
+    serial += serial_cnt[i];
+    mismatch += mismatches[i];
+  }
+  if (mismatch != 0)
+    fail("Threads saw %d values from the wrong round", mismatch);
+  if (serial != 2 * ROUNDS)
+    fail("%d threads were last to arrive over %d barriers", serial, 2 * ROUNDS);
+  msg("%d threads, %d barriers: %llu cycles per barrier", NUM_THREADS, 2 * ROUNDS,
+      cycles / (2 * ROUNDS));
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "missing begin message" unless grep ($_ eq "(barrier-rounds) begin", @output);
+fail "missing end message" unless grep ($_ eq "(barrier-rounds) end", @output);
+fail "missing exit status" unless grep ($_ eq "barrier-rounds: exit(0)", @output);
+fail "missing measurement"
+  unless grep (/^\(barrier-rounds\) 8 threads, 1000 barriers: \d+ cycles per barrier$/, @output);
+pass;
@@ -0,0 +1,65 @@
+/* Checks that pthread_cond_signal() wakes one waiter and that
+   pthread_cond_broadcast() wakes all of them.
+
+   NUM_THREADS threads wait on a condition variable for tickets
+   handed out under a lock.  Main hands out one ticket with a
+   signal, waits for it to be taken, and then hands out the rest
+   at once with a broadcast. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <syscall.h>
+#include <pthread.h>
+
+#define NUM_THREADS 6
+
+lock_t lock;
+pthread_cond_t ticket_cond;
+pthread_cond_t taken_cond;
+int tickets;
+int taken;
+
+void thread_function(void* arg_);
+
+/* Waits for a ticket and takes it. */
+void thread_function(void* arg_ UNUSED) {
+  lock_acquire(&lock);
+  while (tickets == 0)
+    pthread_cond_wait(&ticket_cond, &lock);
+  tickets--;
+  taken++;
+  pthread_cond_signal(&taken_cond);
+  lock_release(&lock);
+}
+
+void test_main(void) {
+  lock_check_init(&lock);
+  if (!pthread_cond_init(&ticket_cond) || !pthread_cond_init(&taken_cond))
+    fail("pthread_cond_init() failed");
+  if (pthread_cond_init(NULL))
+    fail("Initialized NULL condition variable");
+
+  tid_t tids[NUM_THREADS];
+  for (int i = 0; i < NUM_THREADS; i++)
+    tids[i] = pthread_check_create(thread_function, NULL);
+
+  lock_acquire(&lock);
+  tickets = 1;
+  pthread_cond_signal(&ticket_cond);
+  while (taken < 1)
+    pthread_cond_wait(&taken_cond, &lock);
+  msg("Signal let one thread through");
+
+  tickets = NUM_THREADS - 1;
+  pthread_cond_broadcast(&ticket_cond);
+  while (taken < NUM_THREADS)
+    pthread_cond_wait(&taken_cond, &lock);
+  lock_release(&lock);
+  msg("Broadcast let the rest through");
+
+  for (int i = 0; i < NUM_THREADS; i++)
+    pthread_check_join(tids[i]);
+  if (tickets != 0)
+    fail("%d tickets left over", tickets);
+  msg("PASS");
+}
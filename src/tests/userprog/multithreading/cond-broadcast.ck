@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_USER_FAULTS => 1, [<<'EOF']);
+(cond-broadcast) begin
+(cond-broadcast) Signal let one thread through
+(cond-broadcast) Broadcast let the rest through
+(cond-broadcast) PASS
+(cond-broadcast) end
+cond-broadcast: exit(0)
+EOF
+pass;
@@ -0,0 +1,63 @@
+/* Checks that a reader-writer lock keeps readers from seeing a
+   half-finished write.
+
+   Writer threads rewrite every element of a shared array to the
+   same new value, one element at a time, while reader threads
+   check that every element is equal. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <syscall.h>
+#include <pthread.h>
+
+#define NUM_READERS 4
+#define NUM_WRITERS 2
+#define ITERATIONS 50
+#define ARRAY_SIZE 64
+
+pthread_rwlock_t rwlock;
+int data[ARRAY_SIZE];
+int torn_reads;
+
+void reader_function(void* arg_);
+void writer_function(void* arg_);
+
+/* Checks that the array is consistent ITERATIONS times. */
+void reader_function(void* arg_ UNUSED) {
+  for (int i = 0; i < ITERATIONS; i++) {
+    pthread_rwlock_rdlock(&rwlock);
+    for (int j = 1; j < ARRAY_SIZE; j++)
+      if (data[j] != data[0]) {
+        torn_reads++;
+        break;
+      }
+    pthread_rwlock_unlock(&rwlock);
+  }
+}
+
+/* Increments every element of the array ITERATIONS times. */
+void writer_function(void* arg_ UNUSED) {
+  for (int i = 0; i < ITERATIONS; i++) {
+    pthread_rwlock_wrlock(&rwlock);
+    for (int j = 0; j < ARRAY_SIZE; j++)
+      data[j]++;
+    pthread_rwlock_unlock(&rwlock);
+  }
+}
+
+void test_main(void) {
+  if (!pthread_rwlock_init(&rwlock))
+    fail("pthread_rwlock_init() failed");
+
+  tid_t tids[NUM_READERS + NUM_WRITERS];
+  for (int i = 0; i < NUM_READERS + NUM_WRITERS; i++)
+    tids[i] = pthread_check_create(i < NUM_READERS ? reader_function : writer_function, NULL);
+  for (int i = 0; i < NUM_READERS + NUM_WRITERS; i++)
+    pthread_check_join(tids[i]);
+
+  if (torn_reads != 0)
+    fail("Readers saw %d half-finished writes", torn_reads);
+  if (data[0] != NUM_WRITERS * ITERATIONS)
+    fail("Writers made %d increments, expected %d", data[0], NUM_WRITERS * ITERATIONS);
+  msg("PASS");
+}
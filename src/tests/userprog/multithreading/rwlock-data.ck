@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_USER_FAULTS => 1, [<<'EOF']);
+(rwlock-data) begin
+(rwlock-data) PASS
+(rwlock-data) end
+rwlock-data: exit(0)
+EOF
+pass;
@@ -0,0 +1,65 @@
+/* Checks that every thread's user stack grows on demand.
+
+   Each thread, the main thread included, recurses deep enough,
+   with a large array in each frame, to need dozens of pages of
+   stack.  The threads wait at a barrier at the bottom of the
+   recursion, so that all of the stacks are deep at once, and
+   then check that each frame kept its own contents. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <pthread.h>
+
+#define NUM_THREADS 4
+#define DEPTH 32
+#define FRAME_SIZE 4096
+
+pthread_barrier_t barrier;
+
+void thread_function(void* arg_);
+
+/* Fills a frame with a byte that depends on ID and DEPTH,
+   recurses, and checks that the frame is unchanged.  Returns
+   the number of frames checked. */
+static int recurse(int id, int depth) {
+  volatile char frame[FRAME_SIZE];
+  char fill = id * DEPTH + depth;
+  int frame_cnt;
+
+  for (int i = 0; i < FRAME_SIZE; i++)
+    frame[i] = fill;
+  if (depth > 0)
+    frame_cnt = recurse(id, depth - 1);
+  else {
+    pthread_barrier_wait(&barrier);
+    frame_cnt = 0;
+  }
+  for (int i = 0; i < FRAME_SIZE; i++)
+    if (frame[i] != fill)
+      fail("thread %d: frame at depth %d changed", id, depth);
+  return frame_cnt + 1;
+}
+
+void thread_function(void* arg_) {
+  int id = *(int*)arg_;
+  if (recurse(id, DEPTH) != DEPTH + 1)
+    fail("thread %d: wrong frame count", id);
+}
+
+void test_main(void) {
+  int ids[NUM_THREADS];
+  tid_t tids[NUM_THREADS];
+
+  if (!pthread_barrier_init(&barrier, NUM_THREADS + 1))
+    fail("pthread_barrier_init() failed");
+  for (int i = 0; i < NUM_THREADS; i++) {
+    ids[i] = i + 1;
+    tids[i] = pthread_check_create(thread_function, &ids[i]);
+  }
+  if (recurse(0, DEPTH) != DEPTH + 1)
+    fail("main thread: wrong frame count");
+  for (int i = 0; i < NUM_THREADS; i++)
+    pthread_check_join(tids[i]);
+  msg("Every stack grew");
+  msg("PASS");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_USER_FAULTS => 1, [<<'EOF']);
+(stack-grow) begin
+(stack-grow) Every stack grew
+(stack-grow) PASS
+(stack-grow) end
+stack-grow: exit(0)
+EOF
+pass;
@@ -0,0 +1,25 @@
+/* Takes and releases an uncontended lock and semaphore many
+   times.  With no other thread to wait for or wake, none of
+   these operations may trap into the kernel; the check counts
+   futex system calls in the kernel's shutdown statistics. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <syscall.h>
+
+#define ITERS 10000
+
+void test_main(void) {
+  lock_t lock;
+  sema_t sema;
+
+  lock_check_init(&lock);
+  sema_check_init(&sema, 1);
+  for (int i = 0; i < ITERS; i++) {
+    lock_acquire(&lock);
+    lock_release(&lock);
+    sema_down(&sema);
+    sema_up(&sema);
+  }
+  msg("Took and released the lock and semaphore %d times.", ITERS);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+check_expected (IGNORE_USER_FAULTS => 1, [<<'EOF']);
+(synch-fast) begin
+(synch-fast) Took and released the lock and semaphore 10000 times.
+(synch-fast) end
+synch-fast: exit(0)
+EOF
+my (@output) = read_text_file ("$test.output");
+my ($stats) = grep (/^Futex: \d+ waits, \d+ wakes$/, @output);
+fail "missing futex statistics\n" unless defined $stats;
+my ($waits, $wakes) = $stats =~ /^Futex: (\d+) waits, (\d+) wakes$/;
+fail "uncontended operations made $waits futex_wait and $wakes futex_wake calls\n"
+  if $waits != 0 || $wakes != 0;
+pass;
@@ -0,0 +1,62 @@
+/* Checks that __thread variables are private to each thread and
+   start out with their initial values, and that get_tid()
+   returns the TID that pthread_create() gave the thread.
+
+   Each thread checks a variable with an initializer (.tdata) and
+   one without (.tbss), overwrites both with values of its own,
+   waits at a barrier until every thread has done the same, and
+   checks that its values survived. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+#include <syscall.h>
+#include <pthread.h>
+
+#define NUM_THREADS 5
+
+__thread int initialized = 0x1234;
+__thread int zeroed;
+
+pthread_barrier_t barrier;
+tid_t seen_tids[NUM_THREADS + 1];
+
+void thread_function(void* arg_);
+
+/* Checks the running thread's TLS, leaving the results in
+   SEEN_TIDS[ID]. */
+static void check_tls(int id) {
+  if (initialized != 0x1234 || zeroed != 0)
+    fail("thread %d started with initialized=%#x zeroed=%d", id, initialized, zeroed);
+  initialized = id;
+  zeroed = -id;
+  pthread_barrier_wait(&barrier);
+  if (initialized != id || zeroed != -id)
+    fail("thread %d's TLS changed to initialized=%d zeroed=%d", id, initialized, zeroed);
+  seen_tids[id] = get_tid();
+}
+
+void thread_function(void* arg_) { check_tls(*(int*)arg_); }
+
+void test_main(void) {
+  int ids[NUM_THREADS];
+  tid_t tids[NUM_THREADS];
+
+  if (!pthread_barrier_init(&barrier, NUM_THREADS + 1))
+    fail("pthread_barrier_init() failed");
+  for (int i = 0; i < NUM_THREADS; i++) {
+    ids[i] = i + 1;
+    tids[i] = pthread_check_create(thread_function, &ids[i]);
+  }
+  check_tls(0);
+  for (int i = 0; i < NUM_THREADS; i++)
+    pthread_check_join(tids[i]);
+  msg("Every thread had its own TLS");
+
+  if (seen_tids[0] != get_tid())
+    fail("get_tid() changed in the main thread");
+  for (int i = 0; i < NUM_THREADS; i++)
+    if (seen_tids[i + 1] != tids[i])
+      fail("thread %d: get_tid() returned %d, not %d", i + 1, seen_tids[i + 1], tids[i]);
+  msg("get_tid() matched pthread_create()");
+  msg("PASS");
+}
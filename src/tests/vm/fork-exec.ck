@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "missing begin message" unless grep ($_ eq "(fork-exec) begin", @output);
+fail "missing end message" unless grep ($_ eq "(fork-exec) end", @output);
+fail "missing child exit status" unless grep ($_ eq "fork-exec: exit(42)", @output);
+fail "child's writes reached the parent"
+  unless grep ($_ eq "(fork-exec) child's writes stayed in the child", @output);
+fail "missing fork measurement"
+  unless grep (/^\(fork-exec\) 20 forks: \d+ cycles per fork$/, @output);
+fail "missing exec measurement"
+  unless grep (/^\(fork-exec\) 20 execs: \d+ cycles per exec$/, @output);
+pass;
@@ -0,0 +1,72 @@
+/* Runs with the user pool limited to 64 pages and fills 1 MB of
+   memory, four times the pool, so that most of it must be evicted
+   to swap and read back.  Each page gets its own pattern, so a
+   page that comes back from the wrong swap slot is caught.
+
+   Then forks while most of the buffer is in swap.  The child and
+   the parent share those swap slots until one of them writes.
+   The child checks and overwrites every page, and the parent
+   then checks that its own copy is unchanged. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 256
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Returns the byte expected at offset OFS of page PAGE in
+   generation GEN. */
+static char pattern(size_t page, size_t ofs, int gen) {
+  return (page * 7 + ofs / 512 + gen * 13) & 0xff;
+}
+
+/* Fills every page of BUF with generation GEN's pattern. */
+static void fill(int gen) {
+  for (size_t page = 0; page < PAGE_CNT; page++)
+    for (size_t ofs = 0; ofs < PAGE_SIZE; ofs += 512)
+      memset(buf + page * PAGE_SIZE + ofs, pattern(page, ofs, gen), 512);
+}
+
+/* Returns true if every page of BUF holds generation GEN's
+   pattern. */
+static bool check(int gen) {
+  for (size_t page = 0; page < PAGE_CNT; page++)
+    for (size_t ofs = 0; ofs < PAGE_SIZE; ofs++)
+      if (buf[page * PAGE_SIZE + ofs] != pattern(page, ofs, gen))
+        return false;
+  return true;
+}
+
+void test_main(void) {
+  msg("fill");
+  fill(0);
+  msg("check");
+  if (!check(0))
+    fail("data read back from swap is wrong");
+
+  msg("rewrite");
+  fill(1);
+  if (!check(1))
+    fail("rewritten data read back from swap is wrong");
+
+  msg("fork");
+  pid_t pid = fork();
+  if (pid == 0) {
+    if (!check(1))
+      exit(1);
+    fill(2);
+    exit(check(2) ? 0 : 2);
+  }
+  if (pid < 0)
+    fail("fork failed");
+  int status = wait(pid);
+  if (status != 0)
+    fail("child saw wrong data (status %d)", status);
+  if (!check(1))
+    fail("child's writes reached the parent");
+  msg("parent and child saw their own data");
+}
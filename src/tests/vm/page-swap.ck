@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-swap) begin
+(page-swap) fill
+(page-swap) check
+(page-swap) rewrite
+(page-swap) fork
+(page-swap) parent and child saw their own data
+(page-swap) end
+EOF
+pass;
@@ -0,0 +1,154 @@
+#include "threads/fpu.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Lazy FPU context switching.
+
+   Most threads never execute a floating-point instruction, so
+   rather than saving and restoring the FPU on every context
+   switch, the FPU keeps holding the state of the last thread to
+   use it, its owner, until some other thread needs it.
+   Switching to any thread but the owner sets the TS ("task
+   switched") bit in CR0, which makes that thread's first FPU
+   instruction raise #NM (device not available).  The #NM handler
+   saves the owner's state into the owner's struct thread, loads
+   the running thread's state, or initializes a fresh one if the
+   thread has never used the FPU, and makes the running thread
+   the owner.  Switching back to the owner clears TS, so a thread
+   that is the only one using the FPU never traps at all.
+
+   The FPU is not saved on interrupt entry, so external interrupt
+   handlers must not use it.  Kernel code that uses it on behalf
+   of a user process, which shares one FPU state with the
+   process, must bracket that use with fpu_kernel_begin() and
+   fpu_kernel_end(). */
+
+#define CR0_TS 0x00000008 /* Task Switched. */
+
+/* Thread whose state is in the FPU, or NULL if none. */
+static struct thread* fpu_owner;
+
+/* Number of #NM traps taken, each a lazy FPU switch. */
+static long long fpu_trap_cnt;
+
+static intr_handler_func fpu_not_available;
+
+/* Returns the value of CR0. */
+static inline uint32_t rcr0(void) {
+  uint32_t cr0;
+  asm volatile("movl %%cr0, %0" : "=r"(cr0));
+  return cr0;
+}
+
+/* Sets CR0 to CR0. */
+static inline void lcr0(uint32_t cr0) { asm volatile("movl %0, %%cr0" : : "r"(cr0)); }
+
+/* Registers the #NM handler and arms it, so that the first FPU
+   instruction executed by any thread gives the FPU an owner. */
+void fpu_init(void) {
+  intr_register_int(7, 0, INTR_OFF, fpu_not_available, "#NM Device Not Available Exception");
+  lcr0(rcr0() | CR0_TS);
+}
+
+/* Prepares the FPU for a switch to NEXT: NEXT may use the FPU
+   directly if it owns it, and traps on first use otherwise.
+   Called by the scheduler with interrupts off. */
+void fpu_switch(struct thread* next) {
+  uint32_t cr0 = rcr0();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (next == fpu_owner) {
+    if (cr0 & CR0_TS)
+      asm volatile("clts");
+  } else if (!(cr0 & CR0_TS))
+    lcr0(cr0 | CR0_TS);
+}
+
+/* Discards the FPU state of T, which is exiting.  Called with
+   interrupts off. */
+void fpu_release(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (fpu_owner == t)
+    fpu_owner = NULL;
+}
+
+/* Discards the running thread's FPU state, so that its next FPU
+   instruction starts from a freshly initialized FPU, as a new
+   user process or thread expects. */
+void fpu_reset(void) {
+  struct thread* cur = thread_current();
+  enum intr_level old_level = intr_disable();
+
+  cur->fpu_used = false;
+  if (fpu_owner == cur) {
+    fpu_owner = NULL;
+    lcr0(rcr0() | CR0_TS);
+  }
+  intr_set_level(old_level);
+}
+
+/* Gives the running thread, a forked child, a copy of PARENT's
+   FPU state.  If PARENT owns the FPU, its state is first saved
+   into PARENT, which then traps on its next FPU instruction and
+   reloads it.  PARENT must not run until this returns. */
+void fpu_fork(struct thread* parent) {
+  struct thread* cur = thread_current();
+  enum intr_level old_level = intr_disable();
+
+  if (fpu_owner == parent) {
+    asm volatile("clts");
+    asm volatile("fnsave %0" : "=m"(parent->fpu));
+    fpu_owner = NULL;
+  } else if (fpu_owner == cur)
+    fpu_owner = NULL;
+  lcr0(rcr0() | CR0_TS);
+
+  cur->fpu = parent->fpu;
+  cur->fpu_used = parent->fpu_used;
+  intr_set_level(old_level);
+}
+
+/* Saves the running thread's FPU state into SAVE and gives the
+   kernel a freshly initialized FPU to compute with.  The thread
+   may be preempted before the matching fpu_kernel_end(), which
+   restores the state from SAVE. */
+void fpu_kernel_begin(struct fpu_state* save) {
+  ASSERT(!intr_context());
+
+  /* Traps first if another thread owns the FPU. */
+  asm volatile("fnsave %0" : "=m"(*save));
+}
+
+/* Restores the FPU state saved by fpu_kernel_begin() in SAVE. */
+void fpu_kernel_end(const struct fpu_state* save) {
+  ASSERT(!intr_context());
+
+  asm volatile("frstor %0" : : "m"(*save));
+}
+
+/* Returns the number of #NM traps taken so far.  A switch
+   between threads that leave the FPU alone takes none. */
+long long fpu_trap_count(void) { return fpu_trap_cnt; }
+
+/* #NM handler.  Makes the running thread the owner of the FPU. */
+static void fpu_not_available(struct intr_frame* f UNUSED) {
+  struct thread* cur = thread_current();
+
+  ASSERT(!intr_context());
+  ASSERT(fpu_owner != cur);
+
+  fpu_trap_cnt++;
+  asm volatile("clts");
+  if (fpu_owner != NULL)
+    asm volatile("fnsave %0" : "=m"(fpu_owner->fpu));
+  if (cur->fpu_used)
+    asm volatile("frstor %0" : : "m"(cur->fpu));
+  else {
+    asm volatile("fninit");
+    cur->fpu_used = true;
+  }
+  fpu_owner = cur;
+}
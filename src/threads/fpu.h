@@ -0,0 +1,24 @@
+#ifndef THREADS_FPU_H
+#define THREADS_FPU_H
+
+#include <stdint.h>
+
+/* x87 FPU state, in the 108-byte format of FSAVE and FRSTOR. */
+struct fpu_state {
+  uint8_t bytes[108];
+};
+
+struct thread;
+
+void fpu_init(void);
+void fpu_switch(struct thread* next);
+void fpu_release(struct thread*);
+void fpu_reset(void);
+void fpu_fork(struct thread* parent);
+long long fpu_trap_count(void);
+
+/* FPU use by kernel code on behalf of a user process. */
+void fpu_kernel_begin(struct fpu_state*);
+void fpu_kernel_end(const struct fpu_state*);
+
+#endif /* threads/fpu.h */
@@ -14,19 +14,24 @@
 #include "devices/serial.h"
 #include "devices/shutdown.h"
 #include "devices/timer.h"
+#include "devices/tsc.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/synch.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
@@ -41,6 +46,10 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/swap.h"
+#endif
 
 extern struct lock file_lock;
 
@@ -99,6 +108,8 @@ int main(void) {
   palloc_init(user_page_limit);
   malloc_init();
   paging_init();
+  trace_init();
+  profile_init();
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -108,12 +119,14 @@ int main(void) {
 
   /* Initialize interrupt handlers. */
   intr_init();
+  fpu_init();
   timer_init();
   kbd_init();
   input_init();
 #ifdef USERPROG
   exception_init();
   syscall_init();
+  futex_init();
 #endif
   lock_init(&file_lock);
 
@@ -134,6 +147,12 @@ int main(void) {
   filesys_init(format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize virtual memory. */
+  frame_init();
+  swap_init();
+#endif
+
   printf("Boot complete.\n");
 
   /* Run actions specified on kernel command line. */
@@ -251,6 +270,22 @@ static char** parse_options(char** argv) {
 #endif
     else if (!strcmp(name, "-rs"))
       random_init(atoi(value));
+    else if (!strcmp(name, "-tickless"))
+      timer_tickless = true;
+    else if (!strcmp(name, "-profile"))
+      profile_enabled = true;
+    else if (!strcmp(name, "-trace")) {
+      if (value == NULL)
+        trace_configure(TRACE_SERIAL);
+      else if (!strcmp(value, "scratch"))
+        trace_configure(TRACE_SCRATCH);
+      else
+        PANIC("unknown trace destination `%s' (use -h for help)", value);
+    } else if (!strcmp(name, "-tsc-khz")) {
+      if (value == NULL || atoi(value) < 1000)
+        PANIC("-tsc-khz needs a rate of at least 1000 kHz (use -h for help)");
+      tsc_set_khz(atoi(value));
+    }
     else if (!strcmp(name, "-sched")) {
       if (!strcmp(value, "fifo"))
         scheduler_flags[SCHED_FIFO] = 1;
@@ -260,6 +295,10 @@ static char** parse_options(char** argv) {
         scheduler_flags[SCHED_FAIR] = 1;
       else if (!strcmp(value, "mlfqs"))
         scheduler_flags[SCHED_MLFQS] = 1;
+      else if (!strcmp(value, "stride"))
+        scheduler_flags[SCHED_STRIDE] = 1;
+      else if (!strcmp(value, "edf"))
+        scheduler_flags[SCHED_EDF] = 1;
       else
         PANIC("unknown scheduler option `%s' (use -h for help)", value);
     }
@@ -285,7 +324,7 @@ static char** parse_options(char** argv) {
     active_sched_policy = SCHED_DEFAULT;
   else if (sched_flags_set > 1)
     PANIC("too many scheduler flags set: set at most one of \"-sched-fifo\", \"-sched-prio\", "
-          "\"-sched-fair\", \"-sched-mlfqs\"");
+          "\"-sched-fair\", \"-sched-mlfqs\", \"-sched-stride\", \"-sched-edf\"");
   else if (scheduler_flags[SCHED_FIFO])
     active_sched_policy = SCHED_FIFO;
   else if (scheduler_flags[SCHED_PRIO])
@@ -294,6 +333,10 @@ static char** parse_options(char** argv) {
     active_sched_policy = SCHED_FAIR;
   else if (scheduler_flags[SCHED_MLFQS])
     active_sched_policy = SCHED_MLFQS;
+  else if (scheduler_flags[SCHED_STRIDE])
+    active_sched_policy = SCHED_STRIDE;
+  else if (scheduler_flags[SCHED_EDF])
+    active_sched_policy = SCHED_EDF;
   else
     PANIC("kernel bug in init.c: unreachable case");
 
@@ -435,6 +478,16 @@ static void usage(void) {
          "\"-sched-fair\", \"-sched-prio\".\n"
          "  -sched-prio        Use strict-priority round-robin scheduler. Mutually exclusive with "
          "\"-sched-fair\", \"-sched-mlfqs\".\n"
+         "  -sched-stride      Use proportional-share stride scheduler. Mutually exclusive with "
+         "the other \"-sched\" options.\n"
+         "  -sched-edf         Run admitted deadline threads earliest-deadline-first, ahead of "
+         "strict-priority threads.\n"
+         "  -tickless          Stop the timer tick while idle until the next timer is due.\n"
+         "  -profile           Sample the running code on each timer tick, and print the\n"
+         "                     samples at shutdown.\n"
+         "  -trace[=scratch]   Trace kernel events, and write the trace to the console or\n"
+         "                     the scratch disk at shutdown.\n"
+         "  -tsc-khz=KHZ       Skip timer calibration, taking the TSC to run at KHZ kHz.\n"
 #ifdef USERPROG
          "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif // USERPROG
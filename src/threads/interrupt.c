@@ -7,6 +7,7 @@
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
 #include "userprog/process.h"
@@ -51,10 +52,26 @@ static unsigned int unexpected_cnt[INTR_CNT];
 static bool in_external_intr; /* Are we processing an external interrupt? */
 static bool yield_on_return;  /* Should we yield on interrupt return? */
 
+/* Softirqs are the deferred half of external interrupt
+   handling.  A handler that has more to do than acknowledge its
+   device raises a softirq, and the softirq's function runs once
+   the handler has returned and the PIC has been acknowledged,
+   with interrupts turned back on, before the interrupted thread
+   resumes.  Softirqs never nest: an interrupt that arrives while
+   they run only raises more of them, for the outer loop in
+   softirq_run() to pick up.  Like external interrupt handlers,
+   softirq functions count as interrupt context and may not
+   sleep. */
+static softirq_func* softirq_handlers[SOFTIRQ_CNT];
+static uint32_t softirq_pending; /* Bitmap of raised softirqs. */
+static bool in_softirq;          /* Are we running softirqs? */
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init(void);
 static void pic_end_of_interrupt(int irq);
 
+static void softirq_run(void);
+
 /* Interrupt Descriptor Table helpers. */
 static uint64_t make_intr_gate(void (*)(void), int dpl);
 static uint64_t make_trap_gate(void (*)(void), int dpl);
@@ -86,7 +103,7 @@ enum intr_level intr_set_level(enum intr_level level) {
 /* Enables interrupts and returns the previous interrupt status. */
 enum intr_level intr_enable(void) {
   enum intr_level old_level = intr_get_level();
-  ASSERT(!intr_context());
+  ASSERT(!in_external_intr);
 
   /* Enable interrupts by setting the interrupt flag.
 
@@ -193,19 +210,61 @@ void intr_register_int(uint8_t vec_no, int dpl, enum intr_level level, intr_hand
   register_handler(vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-   and false at all other times. */
-bool intr_context(void) { return in_external_intr; }
+/* Returns true during processing of an external interrupt or of
+   the softirqs that follow it, and false at all other times. */
+bool intr_context(void) { return in_external_intr || in_softirq; }
 
-/* During processing of an external interrupt, directs the
-   interrupt handler to yield to a new process just before
-   returning from the interrupt.  May not be called at any other
-   time. */
+/* During processing of an external interrupt or a softirq,
+   directs the interrupt handler to yield to a new process just
+   before returning from the interrupt.  May not be called at any
+   other time. */
 void intr_yield_on_return(void) {
   ASSERT(intr_context());
   yield_on_return = true;
 }
 
+/* Registers FUNC to run whenever softirq SOFTIRQ is raised. */
+void softirq_register(enum softirq softirq, softirq_func* func) {
+  ASSERT(softirq < SOFTIRQ_CNT);
+  ASSERT(softirq_handlers[softirq] == NULL);
+  softirq_handlers[softirq] = func;
+}
+
+/* Marks SOFTIRQ to run on the way back from the current external
+   interrupt.  Raising a softirq that is already pending has no
+   further effect. */
+void softirq_raise(enum softirq softirq) {
+  ASSERT(softirq < SOFTIRQ_CNT);
+  ASSERT(intr_context());
+  ASSERT(intr_get_level() == INTR_OFF);
+  softirq_pending |= 1u << softirq;
+}
+
+/* Runs pending softirqs with interrupts on, until none are left.
+   Called with interrupts off at the end of an external
+   interrupt, and returns with them off.  Does nothing if
+   softirqs are already running further down the stack. */
+static void softirq_run(void) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (in_softirq)
+    return;
+  in_softirq = true;
+  while (softirq_pending != 0) {
+    uint32_t pending = softirq_pending;
+    softirq_pending = 0;
+
+    trace_event(TRACE_SOFTIRQ_ENTER, pending);
+    intr_enable();
+    for (int i = 0; i < SOFTIRQ_CNT; i++)
+      if (pending & (1u << i))
+        softirq_handlers[i]();
+    intr_disable();
+    trace_event(TRACE_SOFTIRQ_EXIT, pending);
+  }
+  in_softirq = false;
+}
+
 /* 8259A Programmable Interrupt Controller. */
 
 /* Initializes the PICs.  Refer to [8259A] for details.
@@ -325,13 +384,16 @@ void intr_handler(struct intr_frame* frame) {
      We only handle one at a time (so interrupts must be off)
      and they need to be acknowledged on the PIC (see below).
      An external interrupt handler cannot sleep. */
+  trace_event(TRACE_INTR_ENTER, frame->vec_no);
   external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
   if (external) {
     ASSERT(intr_get_level() == INTR_OFF);
-    ASSERT(!intr_context());
+    ASSERT(!in_external_intr);
 
     in_external_intr = true;
-    yield_on_return = false;
+
+    /* Catch up on any ticks skipped while idle. */
+    timer_tickless_exit();
   }
 
   /* Invoke the interrupt's handler. */
@@ -348,16 +410,27 @@ void intr_handler(struct intr_frame* frame) {
   /* Complete the processing of an external interrupt. */
   if (external) {
     ASSERT(intr_get_level() == INTR_OFF);
-    ASSERT(intr_context());
+    ASSERT(in_external_intr);
 
     in_external_intr = false;
     pic_end_of_interrupt(frame->vec_no);
   }
+  trace_event(TRACE_INTR_EXIT, frame->vec_no);
+
+  /* Run the deferred half of the interrupt.  An interrupt that
+     arrived while softirqs were running returns straight to them
+     and leaves exiting and yielding to the outermost one. */
+  if (external)
+    softirq_run();
+  if (in_softirq)
+    return;
+
   struct thread* cur = thread_current();
   if (cur->is_exiting) {
     pthread_exit();
   }
   if (external && yield_on_return) {
+    yield_on_return = false;
     thread_yield();
   }
 
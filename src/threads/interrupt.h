@@ -19,7 +19,6 @@ enum intr_level intr_disable(void);
 struct intr_frame {
   /* Pushed by intr_entry in intr-stubs.S.
        These are the interrupted task's saved registers. */
-  uint8_t fpu[108];
   uint32_t edi;       /* Saved EDI. */
   uint32_t esi;       /* Saved ESI. */
   uint32_t ebp;       /* Saved EBP. */
@@ -62,6 +61,18 @@ void intr_register_int(uint8_t vec, int dpl, enum intr_level, intr_handler_func*
 bool intr_context(void);
 void intr_yield_on_return(void);
 
+/* Softirqs, run after an external interrupt's handler with
+   interrupts on. */
+enum softirq {
+  SOFTIRQ_TIMER, /* Expired timers, from devices/timer.c. */
+  SOFTIRQ_CNT
+};
+
+typedef void softirq_func(void);
+
+void softirq_register(enum softirq, softirq_func*);
+void softirq_raise(enum softirq);
+
 void intr_dump_frame(const struct intr_frame*);
 const char* intr_name(uint8_t vec);
 
@@ -9,6 +9,7 @@
 #include <string.h>
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -74,6 +75,14 @@ void* palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
   page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
   lock_release(&pool->lock);
 
+  /* Exited threads' pages may be sitting in the thread page
+     cache.  Give them back to the kernel pool and try again. */
+  if (page_idx == BITMAP_ERROR && pool == &kernel_pool && thread_page_cache_drain() > 0) {
+    lock_acquire(&pool->lock);
+    page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
+    lock_release(&pool->lock);
+  }
+
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
   else
@@ -0,0 +1,151 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef USERPROG
+#include "userprog/process.h"
+#endif
+
+/* Statistical sampling profiler.
+
+   On every timer interrupt, the timer interrupt handler passes
+   the interrupted frame to profile_sample(), which counts the
+   interrupted EIP, in user or kernel code, along with the pid of
+   the running thread's process, or 0 for a kernel thread or a
+   process still being set up, in a
+   fixed-size open-addressing hash table.  Code that runs with
+   interrupts off is never interrupted, so it never shows up.
+
+   At shutdown, profile_dump() prints the table, along with the
+   name of each process seen, and utils/pintos-profile
+   symbolizes it against kernel.o and the user programs.
+
+   Controlled by kernel command-line option "-profile". */
+
+/* One hash table entry. */
+struct profile_slot {
+  uintptr_t eip;  /* Interrupted instruction. */
+  int pid;        /* Process, or 0 for a kernel thread. */
+  uint32_t count; /* Number of samples, or 0 if the slot is free. */
+};
+
+#define PROFILE_SLOTS 4096 /* Power of 2. */
+#define PROFILE_PAGES DIV_ROUND_UP(PROFILE_SLOTS * sizeof(struct profile_slot), PGSIZE)
+#define PROFILE_PROBES 16 /* Slots to try before dropping a sample. */
+
+/* A process seen while sampling, for naming its samples. */
+struct profile_proc {
+  int pid;
+  char name[16];
+};
+
+#define PROFILE_PROCS 64
+
+bool profile_enabled;
+static struct profile_slot* slots;
+static struct profile_proc procs[PROFILE_PROCS];
+static size_t proc_cnt;
+static uint32_t sample_cnt;  /* Samples taken. */
+static uint32_t dropped_cnt; /* Samples that found no free slot. */
+
+static bool has_process(const struct thread*);
+static void note_process(const struct thread*);
+
+/* Allocates the hash table, if profiling was requested with
+   "-profile".  If memory is short, profiling stays off. */
+void profile_init(void) {
+  if (!profile_enabled)
+    return;
+
+  slots = palloc_get_multiple(PAL_ZERO, PROFILE_PAGES);
+  if (slots == NULL) {
+    printf("profile: out of memory for sample table\n");
+    profile_enabled = false;
+  }
+}
+
+/* Records a sample of the code that F interrupted.  Called from
+   the timer interrupt. */
+void profile_sample(const struct intr_frame* f) {
+  struct thread* t = thread_current();
+  int pid = 0;
+  unsigned h, i;
+
+  if (!profile_enabled)
+    return;
+
+#ifdef USERPROG
+  if (has_process(t))
+    pid = get_pid(t->pcb);
+#endif
+
+  sample_cnt++;
+  h = ((uint32_t)f->eip * 2654435761u) ^ pid;
+  for (i = 0; i < PROFILE_PROBES; i++) {
+    struct profile_slot* s = &slots[(h + i) & (PROFILE_SLOTS - 1)];
+    if (s->count == 0) {
+      s->eip = (uintptr_t)f->eip;
+      s->pid = pid;
+      s->count = 1;
+      note_process(t);
+      return;
+    } else if (s->eip == (uintptr_t)f->eip && s->pid == pid) {
+      s->count++;
+      return;
+    }
+  }
+  dropped_cnt++;
+}
+
+/* Returns true if T belongs to a process whose PCB is far enough
+   along in process_execute() to have its main thread and name
+   set. */
+static bool has_process(const struct thread* t UNUSED) {
+#ifdef USERPROG
+  return t->pcb != NULL && t->pcb->pagedir != NULL;
+#else
+  return false;
+#endif
+}
+
+/* Remembers the name of T's process, if T belongs to one that
+   has not been seen before. */
+static void note_process(const struct thread* t) {
+#ifdef USERPROG
+  size_t i;
+
+  if (!has_process(t))
+    return;
+  for (i = 0; i < proc_cnt; i++)
+    if (procs[i].pid == get_pid(t->pcb))
+      return;
+  if (proc_cnt < PROFILE_PROCS) {
+    procs[proc_cnt].pid = get_pid(t->pcb);
+    strlcpy(procs[proc_cnt].name, t->pcb->process_name, sizeof procs[proc_cnt].name);
+    proc_cnt++;
+  }
+#endif
+}
+
+/* Stops profiling and prints the samples. */
+void profile_dump(void) {
+  size_t i;
+
+  if (!profile_enabled)
+    return;
+  profile_enabled = false;
+
+  printf("Profile: %" PRIu32 " samples, %" PRIu32 " dropped\n", sample_cnt, dropped_cnt);
+  for (i = 0; i < proc_cnt; i++)
+    printf("Profile: process %d %s\n", procs[i].pid, procs[i].name);
+  for (i = 0; i < PROFILE_SLOTS; i++)
+    if (slots[i].count > 0)
+      printf("P %#010" PRIxPTR " %d %" PRIu32 "\n", slots[i].eip, slots[i].pid, slots[i].count);
+  printf("Profile: end\n");
+}
@@ -0,0 +1,203 @@
+#include "threads/schedstat.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/tsc.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+
+/* Scheduler latency and run-time accounting.
+
+   thread.c calls schedstat_ready() whenever it puts a thread on
+   the ready queue, schedstat_switch_out() when a thread gives up
+   the CPU to another, and schedstat_switch_in() once the other
+   has started running.  Each thread records the time stamp
+   counter at the last two events in its struct thread, and the
+   resulting run-queue waits and time slices go into log2
+   histograms kept both per thread and for the whole system.
+
+   The histograms are too big to keep in struct thread, which
+   shares its page with the thread's kernel stack, so each
+   thread's are allocated separately by schedstat_attach() when
+   the thread is created.  A thread whose histograms could not be
+   allocated, like the initial thread, still counts toward the
+   system-wide ones.  Like thread pages, the histograms of exited
+   threads are kept for reuse, so that creating a thread does not
+   go through malloc() every time.
+
+   A switch is voluntary if the thread leaving the CPU has
+   blocked or is exiting, and involuntary if it is still ready to
+   run, whether it was preempted or called thread_yield().
+
+   thread.c leaves the idle thread out, since its waits and
+   slices say nothing about the threads that do work.  All of
+   this runs with interrupts off. */
+
+/* Statistics for all threads, including those that have exited. */
+static struct sched_stats system_stats;
+
+/* Per-thread statistics of exited threads, kept for reuse.
+   Accessed with interrupts off. */
+#define STATS_CACHE_MAX 16
+static struct sched_stats* stats_cache[STATS_CACHE_MAX];
+static size_t stats_cache_cnt;
+
+/* Adds a sample of CYCLES to H. */
+static void hist_add(struct sched_hist* h, uint64_t cycles) {
+  int bucket = 0;
+
+  while (bucket < SCHED_HIST_BUCKETS - 1 && cycles >= (1ULL << (SCHED_HIST_SHIFT + bucket)))
+    bucket++;
+  h->cnt[bucket]++;
+  h->samples++;
+  h->cycles += cycles;
+}
+
+/* Allocates per-thread statistics for T, a thread that is being
+   created.  If memory is short, T goes without. */
+void schedstat_attach(struct thread* t) {
+  struct sched_stats* stats = NULL;
+  enum intr_level old_level;
+
+  old_level = intr_disable();
+  if (stats_cache_cnt > 0)
+    stats = stats_cache[--stats_cache_cnt];
+  intr_set_level(old_level);
+
+  if (stats != NULL)
+    memset(stats, 0, sizeof *stats);
+  else
+    stats = calloc(1, sizeof *stats);
+  t->sched_stats = stats;
+}
+
+/* Releases the per-thread statistics of T, the running thread,
+   which is about to exit. */
+void schedstat_detach(struct thread* t) {
+  struct sched_stats* stats;
+  enum intr_level old_level;
+
+  old_level = intr_disable();
+  stats = t->sched_stats;
+  t->sched_stats = NULL;
+  if (stats != NULL && stats_cache_cnt < STATS_CACHE_MAX) {
+    stats_cache[stats_cache_cnt++] = stats;
+    stats = NULL;
+  }
+  intr_set_level(old_level);
+  free(stats);
+}
+
+/* Records that T has just been made ready to run. */
+void schedstat_ready(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  t->ready_tsc = tsc_read();
+}
+
+/* Records that T, the running thread, is about to give up the
+   CPU to another thread, and ends its time slice. */
+void schedstat_switch_out(struct thread* t) {
+  bool voluntary = t->status != THREAD_READY;
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  /* The initial thread was running before anything was recorded,
+     so its first slice has no start. */
+  if (t->run_tsc != 0) {
+    uint64_t slice = tsc_read() - t->run_tsc;
+    if (t->sched_stats != NULL)
+      hist_add(&t->sched_stats->slice, slice);
+    hist_add(&system_stats.slice, slice);
+  }
+
+  if (voluntary) {
+    if (t->sched_stats != NULL)
+      t->sched_stats->voluntary++;
+    system_stats.voluntary++;
+  } else {
+    if (t->sched_stats != NULL)
+      t->sched_stats->involuntary++;
+    system_stats.involuntary++;
+  }
+}
+
+/* Records that T, the running thread, has just been switched to,
+   which ends its wait on the ready queue and starts its time
+   slice. */
+void schedstat_switch_in(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  t->run_tsc = tsc_read();
+  if (t->ready_tsc != 0) {
+    uint64_t wait = t->run_tsc - t->ready_tsc;
+    if (t->sched_stats != NULL)
+      hist_add(&t->sched_stats->wait, wait);
+    hist_add(&system_stats.wait, wait);
+    t->ready_tsc = 0;
+  }
+}
+
+/* Records that T, which was running and has just been made
+   ready, was chosen to run again without a switch.  It never
+   left the CPU, so neither its wait nor its slice ends here. */
+void schedstat_resume(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  t->ready_tsc = 0;
+}
+
+/* Copies the system-wide statistics into STATS. */
+void schedstat_get(struct sched_stats* stats) {
+  enum intr_level old_level = intr_disable();
+  *stats = system_stats;
+  intr_set_level(old_level);
+}
+
+/* Copies the running thread's statistics into STATS.  Returns
+   false if the thread has none. */
+bool schedstat_get_thread(struct sched_stats* stats) {
+  struct thread* t = thread_current();
+  enum intr_level old_level = intr_disable();
+  bool found = t->sched_stats != NULL;
+
+  if (found)
+    *stats = *t->sched_stats;
+  intr_set_level(old_level);
+  return found;
+}
+
+/* Prints histogram H, titled NAME, skipping empty buckets. */
+static void hist_print(const char* name, const struct sched_hist* h) {
+  int i;
+
+  printf("%s: %" PRIu32 " samples", name, h->samples);
+  if (h->samples > 0)
+    printf(", mean %llu cycles", h->cycles / h->samples);
+  printf("\n");
+
+  for (i = 0; i < SCHED_HIST_BUCKETS; i++) {
+    if (h->cnt[i] == 0)
+      continue;
+    if (i == 0)
+      printf("  [0, 2^%d)", SCHED_HIST_SHIFT);
+    else if (i < SCHED_HIST_BUCKETS - 1)
+      printf("  [2^%d, 2^%d)", SCHED_HIST_SHIFT + i - 1, SCHED_HIST_SHIFT + i);
+    else
+      printf("  [2^%d, ...)", SCHED_HIST_SHIFT + i - 1);
+    printf(": %" PRIu32 "\n", h->cnt[i]);
+  }
+}
+
+/* Prints the system-wide statistics. */
+void schedstat_print(void) {
+  struct sched_stats stats;
+
+  schedstat_get(&stats);
+  printf("Scheduler: %" PRIu32 " voluntary switches, %" PRIu32 " involuntary switches\n",
+         stats.voluntary, stats.involuntary);
+  hist_print("Run-queue wait", &stats.wait);
+  hist_print("Time slice", &stats.slice);
+}
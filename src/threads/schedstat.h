@@ -0,0 +1,42 @@
+#ifndef THREADS_SCHEDSTAT_H
+#define THREADS_SCHEDSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Log2 histogram of durations in time stamp counter cycles.
+   Bucket 0 counts durations under 2**SCHED_HIST_SHIFT cycles,
+   bucket I > 0 those in [2**(SCHED_HIST_SHIFT + I - 1),
+   2**(SCHED_HIST_SHIFT + I)), and the last bucket also counts
+   every longer one. */
+#define SCHED_HIST_BUCKETS 24
+#define SCHED_HIST_SHIFT 10
+struct sched_hist {
+  uint32_t cnt[SCHED_HIST_BUCKETS]; /* Samples per bucket. */
+  uint32_t samples;                 /* Total number of samples. */
+  uint64_t cycles;                  /* Sum of all samples. */
+};
+
+/* Scheduler statistics, for one thread or the whole system. */
+struct sched_stats {
+  struct sched_hist wait;  /* Time spent ready before each dispatch. */
+  struct sched_hist slice; /* Time spent running per dispatch. */
+  uint32_t voluntary;      /* Switches away from a blocked or dying thread. */
+  uint32_t involuntary;    /* Switches away from a thread still ready to run. */
+};
+
+struct thread;
+
+void schedstat_attach(struct thread*);
+void schedstat_detach(struct thread*);
+
+void schedstat_ready(struct thread*);
+void schedstat_switch_out(struct thread*);
+void schedstat_switch_in(struct thread*);
+void schedstat_resume(struct thread*);
+
+void schedstat_get(struct sched_stats*);
+bool schedstat_get_thread(struct sched_stats*);
+void schedstat_print(void);
+
+#endif /* threads/schedstat.h */
@@ -31,7 +31,106 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
-#include "threads/malloc.h"
+#include "threads/trace.h"
+
+static bool waiter_less(const struct rb_elem* a, const struct rb_elem* b, void* aux);
+static void waiter_add(struct rb_tree* queue, struct thread*);
+static void waiter_wake(struct rb_tree* queue);
+static bool donation_enabled(void);
+static bool donor_less(const struct rb_elem* a, const struct rb_elem* b, void* aux);
+static void lock_detach(struct lock*);
+static void lock_attach(struct lock*);
+static void lock_take(struct lock*);
+static int donation_effective_priority(const struct thread*);
+static void donation_propagate(struct thread*);
+
+/* Wait queues.
+
+   Semaphores and condition variables queue their waiting threads
+   in a red-black tree, through each thread's wait_elem, so that
+   the next thread to wake can be found in O(1) and a waiter can
+   be inserted, removed, or moved in O(log n).  Under SCHED_PRIO,
+   SCHED_MLFQS and SCHED_EDF, the policies that schedule from the
+   priority queues, the tree is ordered by effective priority,
+   highest first, and a waiter whose priority changes, whether
+   through donation or the MLFQS formula, is moved to its new
+   place by synch_requeue_waiter().  Under SCHED_EDF, deadline
+   threads, which the scheduler runs ahead of every other thread,
+   also wake ahead of them, earliest deadline first; a thread's
+   deadline only changes while it runs or is made ready, so it
+   stays put while it waits.  Threads that compare equal, and all
+   threads under other policies, wake in the order that they
+   started waiting. */
+
+/* Returns true if waiters wake in priority order. */
+static bool waiters_by_priority(void) {
+  return active_sched_policy == SCHED_PRIO || active_sched_policy == SCHED_MLFQS ||
+         active_sched_policy == SCHED_EDF;
+}
+
+/* Orders waiting threads by deadline under SCHED_EDF, then by
+   effective priority, highest first, or leaves them in arrival
+   order if priority does not apply. */
+static bool waiter_less(const struct rb_elem* a_, const struct rb_elem* b_, void* aux UNUSED) {
+  const struct thread* a = rb_entry(a_, struct thread, wait_elem);
+  const struct thread* b = rb_entry(b_, struct thread, wait_elem);
+
+  if (!waiters_by_priority())
+    return false;
+  if (active_sched_policy == SCHED_EDF && (a->dl_period != 0 || b->dl_period != 0)) {
+    if (a->dl_period == 0 || b->dl_period == 0)
+      return b->dl_period == 0;
+    return a->dl_deadline < b->dl_deadline;
+  }
+  return a->eff_priority > b->eff_priority;
+}
+
+/* Adds T to wait queue QUEUE.  Interrupts must be off. */
+static void waiter_add(struct rb_tree* queue, struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+  ASSERT(t->wait_queue == NULL);
+
+  rb_insert(queue, &t->wait_elem);
+  t->wait_queue = queue;
+}
+
+/* Removes the first thread from wait queue QUEUE, if any, and
+   unblocks it, preempting the running thread if the woken one
+   has a higher priority.  A thread that has not blocked yet is
+   only taken off the queue.  Interrupts must be off. */
+static void waiter_wake(struct rb_tree* queue) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  struct rb_elem* e = rb_min(queue);
+  if (e == NULL)
+    return;
+
+  struct thread* t = rb_entry(e, struct thread, wait_elem);
+  rb_remove(queue, e);
+  t->wait_queue = NULL;
+  if (t->status != THREAD_BLOCKED)
+    return;
+
+  thread_unblock(t);
+  if (waiters_by_priority() && t->eff_priority > thread_current()->eff_priority) {
+    if (intr_context())
+      intr_yield_on_return();
+    else
+      thread_yield();
+  }
+}
+
+/* Moves T, whose effective priority has just changed, to its new
+   place in the wait queue it is blocked on, if any.  Interrupts
+   must be off. */
+void synch_requeue_waiter(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (t->wait_queue != NULL && waiters_by_priority()) {
+    rb_remove(t->wait_queue, &t->wait_elem);
+    rb_insert(t->wait_queue, &t->wait_elem);
+  }
+}
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -46,7 +145,7 @@ void sema_init(struct semaphore* sema, unsigned value) {
   ASSERT(sema != NULL);
 
   sema->value = value;
-  list_init(&sema->waiters);
+  rb_init(&sema->waiters, waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -64,7 +163,7 @@ void sema_down(struct semaphore* sema) {
 
   old_level = intr_disable();
   while (sema->value == 0) {
-    list_push_back(&sema->waiters, &thread_current()->elem);
+    waiter_add(&sema->waiters, thread_current());
     thread_block();
   }
   sema->value--;
@@ -102,28 +201,10 @@ void sema_up(struct semaphore* sema) {
 
   ASSERT(sema != NULL);
 
-  bool should_yield = false;
   old_level = intr_disable();
-  if (!list_empty(&sema->waiters)) {
-    if (active_sched_policy == SCHED_PRIO) {
-      struct thread* wakeup_thread = max_thread_from_list(&sema->waiters);
-      list_remove(&wakeup_thread->elem);
-      thread_unblock(wakeup_thread);
-      should_yield = wakeup_thread->eff_priority > thread_current()->eff_priority;
-
-    } else /*if (active_sched_policy == SCHED_FIFO)*/ {
-      thread_unblock(list_entry(list_pop_front(&sema->waiters), struct thread, elem));
-    }
-  }
   sema->value++;
+  waiter_wake(&sema->waiters);
   intr_set_level(old_level);
-  if (should_yield) {
-    if (intr_context()) {
-      intr_yield_on_return();
-    } else {
-      thread_yield();
-    }
-  }
 }
 
 static void sema_test_helper(void* sema_);
@@ -177,6 +258,7 @@ void lock_init(struct lock* lock) {
 
   lock->holder = NULL;
   sema_init(&lock->semaphore, 1);
+  rb_init(&lock->donors, donor_less, NULL);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -198,30 +280,26 @@ void lock_acquire(struct lock* lock) {
   }
 
   enum intr_level old_level = intr_disable();
-
-  for (struct lock* curr_lock = lock; curr_lock != NULL;
-       curr_lock = curr_lock->holder->waiting_lock) {
-
-    struct donate_pair* p = malloc(sizeof(struct donate_pair));
-    p->lock_name = curr_lock;
-    p->priority = t->eff_priority;
-
-    struct thread* recipient = curr_lock->holder;
-    list_push_back(&recipient->gotten_prio_list, &p->elem);
-    if (t->eff_priority > recipient->eff_priority) {
-      recipient->eff_priority = t->eff_priority;
-    }
+  trace_event(TRACE_LOCK_CONTEND, lock->holder != NULL ? lock->holder->tid : 0);
+
+  /* Donate our priority to the holder while we wait. */
+  if (donation_enabled()) {
+    t->waiting_lock = lock;
+    lock_detach(lock);
+    rb_insert(&lock->donors, &t->donor_elem);
+    lock_attach(lock);
+    if (lock->holder != NULL)
+      donation_propagate(lock->holder);
   }
 
-  t->waiting_lock = lock;
-
   sema_down(&lock->semaphore);
-  lock->holder = thread_current();
 
-  t->waiting_lock = NULL;
+  if (donation_enabled()) {
+    rb_remove(&lock->donors, &t->donor_elem);
+    t->waiting_lock = NULL;
+  }
+  lock_take(lock);
   intr_set_level(old_level);
-
-  return;
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -231,14 +309,17 @@ void lock_acquire(struct lock* lock) {
    This function will not sleep, so it may be called within an
    interrupt handler. */
 bool lock_try_acquire(struct lock* lock) {
+  enum intr_level old_level;
   bool success;
 
   ASSERT(lock != NULL);
   ASSERT(!lock_held_by_current_thread(lock));
 
+  old_level = intr_disable();
   success = sema_try_down(&lock->semaphore);
   if (success)
-    lock->holder = thread_current();
+    lock_take(lock);
+  intr_set_level(old_level);
   return success;
 }
 
@@ -250,30 +331,16 @@ bool lock_try_acquire(struct lock* lock) {
 void lock_release(struct lock* lock) {
   ASSERT(lock != NULL);
   ASSERT(lock_held_by_current_thread(lock));
-  struct thread* t = thread_current();
-  // priority to set this thread to afterwards; =max of remaining donations and base priority
-  int64_t new_prio = t->priority;
 
+  struct thread* t = thread_current();
   enum intr_level old_level = intr_disable();
-  for (struct list_elem* e = list_begin(&t->gotten_prio_list);
-       e != list_end(&t->gotten_prio_list);) {
-    struct donate_pair* p = list_entry(e, struct donate_pair, elem);
-    if (p->lock_name == lock) {
-      // no longer receives donations from this lock
-      struct list_elem* tmp = list_next(e);
-      list_remove(e);
-      free(p);
-      e = tmp;
-    } else {
-      // still receives donations from this lock
-      if (p->priority > new_prio) {
-        new_prio = p->priority;
-      }
-      e = list_next(e);
-    }
-  }
+
+  /* Give back the donations that came through LOCK. */
+  lock_detach(lock);
   lock->holder = NULL;
-  t->eff_priority = new_prio;
+  if (donation_enabled())
+    thread_set_eff_priority(t, donation_effective_priority(t));
+
   sema_up(&lock->semaphore);
   intr_set_level(old_level);
 }
@@ -287,6 +354,141 @@ bool lock_held_by_current_thread(const struct lock* lock) {
   return lock->holder == thread_current();
 }
 
+/* Priority donation.
+
+   A thread waiting on a lock donates its effective priority to
+   the lock's holder, and through it to the holder of any lock
+   that the holder is itself waiting on, and so on.  Each lock
+   keeps the threads waiting on it in its `donors' tree, highest
+   effective priority first, and each thread keeps the locks it
+   holds that have waiters in its `held_locks' tree, ordered by
+   the priority of each lock's top donor.  A thread's effective
+   priority is the greater of its base priority and the priority
+   of the top donor of its first held lock, so it can be
+   recomputed in O(1), and keeping both trees up to date when a
+   priority changes takes O(log n) per lock in the chain.
+   Nothing is allocated.
+
+   A lock is in its holder's `held_locks' tree exactly when it
+   has a holder and at least one donor, and while it is there the
+   priority of its top donor must not change, so every change to
+   a lock's donors goes through lock_detach() and lock_attach().
+
+   SCHED_MLFQS computes priorities itself and does not donate. */
+
+/* Maximum number of locks through which donation propagates. */
+#define DONATION_DEPTH_MAX 8
+
+/* Returns true if waiting threads donate their priority under
+   the active scheduling policy. */
+static bool donation_enabled(void) { return active_sched_policy != SCHED_MLFQS; }
+
+/* Orders threads in a lock's donors tree by effective priority,
+   highest first. */
+static bool donor_less(const struct rb_elem* a_, const struct rb_elem* b_, void* aux UNUSED) {
+  const struct thread* a = rb_entry(a_, struct thread, donor_elem);
+  const struct thread* b = rb_entry(b_, struct thread, donor_elem);
+
+  return a->eff_priority > b->eff_priority;
+}
+
+/* Returns the effective priority of the top donor of LOCK, which
+   must have at least one. */
+static int top_donor_priority(const struct lock* lock) {
+  return rb_entry(rb_min(&lock->donors), struct thread, donor_elem)->eff_priority;
+}
+
+/* Orders locks in a thread's held_locks tree by the priority of
+   their top donors, highest first. */
+static bool held_lock_less(const struct rb_elem* a_, const struct rb_elem* b_,
+                           void* aux UNUSED) {
+  const struct lock* a = rb_entry(a_, struct lock, held_elem);
+  const struct lock* b = rb_entry(b_, struct lock, held_elem);
+
+  return top_donor_priority(a) > top_donor_priority(b);
+}
+
+/* Initializes the priority donation state of new thread T. */
+void lock_donation_init(struct thread* t) {
+  t->waiting_lock = NULL;
+  rb_init(&t->held_locks, held_lock_less, NULL);
+}
+
+/* Returns the highest priority donated to T through the locks it
+   holds, or PRI_MIN - 1 if there is none. */
+int lock_donated_priority(const struct thread* t) {
+  if (rb_empty(&t->held_locks))
+    return PRI_MIN - 1;
+  return top_donor_priority(rb_entry(rb_min(&t->held_locks), struct lock, held_elem));
+}
+
+/* Returns the effective priority that T should have given its
+   base priority and the donations it receives. */
+static int donation_effective_priority(const struct thread* t) {
+  int donated = lock_donated_priority(t);
+  return donated > t->priority ? donated : t->priority;
+}
+
+/* Removes LOCK from its holder's held_locks tree, if it is
+   there, so that its donors may be changed. */
+static void lock_detach(struct lock* lock) {
+  if (lock->holder != NULL && !rb_empty(&lock->donors))
+    rb_remove(&lock->holder->held_locks, &lock->held_elem);
+}
+
+/* Puts LOCK back into its holder's held_locks tree after its
+   donors have been changed, if it belongs there. */
+static void lock_attach(struct lock* lock) {
+  if (lock->holder != NULL && !rb_empty(&lock->donors))
+    rb_insert(&lock->holder->held_locks, &lock->held_elem);
+}
+
+/* Makes the current thread the holder of LOCK, which it has just
+   acquired, taking on the donations of any threads still waiting
+   for it.  Interrupts must be off. */
+static void lock_take(struct lock* lock) {
+  struct thread* t = thread_current();
+
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  lock->holder = t;
+  lock_attach(lock);
+  if (donation_enabled() && !rb_empty(&lock->donors))
+    thread_set_eff_priority(t, donation_effective_priority(t));
+}
+
+/* Brings the effective priority of T up to date after the
+   donations it receives have changed, and passes the change on
+   along the chain of locks that T is waiting on, through at most
+   DONATION_DEPTH_MAX of them.  Interrupts must be off. */
+static void donation_propagate(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  for (int depth = 0; depth < DONATION_DEPTH_MAX; depth++) {
+    int eff_priority = donation_effective_priority(t);
+    if (eff_priority == t->eff_priority)
+      return;
+
+    struct lock* lock = t->waiting_lock;
+    if (lock == NULL) {
+      thread_set_eff_priority(t, eff_priority);
+      return;
+    }
+
+    /* T's place among LOCK's donors, and so LOCK's place among
+       its holder's locks, depend on T's priority. */
+    lock_detach(lock);
+    rb_remove(&lock->donors, &t->donor_elem);
+    thread_set_eff_priority(t, eff_priority);
+    rb_insert(&lock->donors, &t->donor_elem);
+    lock_attach(lock);
+
+    t = lock->holder;
+    if (t == NULL)
+      return;
+  }
+}
+
 /* Initializes a readers-writers lock */
 void rw_lock_init(struct rw_lock* rw_lock) {
   lock_init(&rw_lock->lock);
@@ -345,19 +547,13 @@ void rw_lock_release(struct rw_lock* rw_lock, bool reader) {
   lock_release(&rw_lock->lock);
 }
 
-/* One semaphore in a list. */
-struct semaphore_elem {
-  struct list_elem elem;      /* List element. */
-  struct semaphore semaphore; /* This semaphore. */
-};
-
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
 void cond_init(struct condition* cond) {
   ASSERT(cond != NULL);
 
-  list_init(&cond->waiters);
+  rb_init(&cond->waiters, waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -381,17 +577,23 @@ void cond_init(struct condition* cond) {
    interrupts disabled, but interrupts will be turned back on if
    we need to sleep. */
 void cond_wait(struct condition* cond, struct lock* lock) {
-  struct semaphore_elem waiter;
+  struct thread* t = thread_current();
+  enum intr_level old_level;
 
   ASSERT(cond != NULL);
   ASSERT(lock != NULL);
   ASSERT(!intr_context());
   ASSERT(lock_held_by_current_thread(lock));
 
-  sema_init(&waiter.semaphore, 0);
-  list_push_back(&cond->waiters, &waiter.elem);
+  /* Releasing LOCK may yield to a thread that signals COND, so
+     we join the queue first and then block only until
+     cond_signal() takes us off it. */
+  old_level = intr_disable();
+  waiter_add(&cond->waiters, t);
   lock_release(lock);
-  sema_down(&waiter.semaphore);
+  while (t->wait_queue != NULL)
+    thread_block();
+  intr_set_level(old_level);
   lock_acquire(lock);
 }
 
@@ -403,35 +605,16 @@ void cond_wait(struct condition* cond, struct lock* lock) {
    make sense to try to signal a condition variable within an
    interrupt handler. */
 void cond_signal(struct condition* cond, struct lock* lock UNUSED) {
+  enum intr_level old_level;
+
   ASSERT(cond != NULL);
   ASSERT(lock != NULL);
   ASSERT(!intr_context());
   ASSERT(lock_held_by_current_thread(lock));
 
-  if (!list_empty(&cond->waiters)) {
-    struct semaphore* max_sema = NULL;
-    struct list_elem* max_e = NULL;
-    if (active_sched_policy == SCHED_PRIO) {
-      int64_t p_max;
-      for (struct list_elem* e = list_begin(&cond->waiters); e != list_end(&cond->waiters);
-           e = list_next(e)) {
-        struct semaphore* s = &list_entry(e, struct semaphore_elem, elem)->semaphore;
-        ASSERT(list_size(&s->waiters) == 1);
-        struct thread* t = list_entry(list_front(&s->waiters), struct thread, elem);
-        if (max_sema == NULL || t->eff_priority > p_max) {
-          max_sema = s;
-          p_max = t->eff_priority;
-          max_e = e;
-        }
-      }
-    } else /*if(active_sched_policy == SCHED_FIFO)*/ {
-      max_e = list_begin(&cond->waiters);
-      max_sema = &list_entry(max_e, struct semaphore_elem, elem)->semaphore;
-    }
-    list_remove(max_e);
-    ASSERT(max_sema != NULL);
-    sema_up(max_sema);
-  }
+  old_level = intr_disable();
+  waiter_wake(&cond->waiters);
+  intr_set_level(old_level);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -444,6 +627,6 @@ void cond_broadcast(struct condition* cond, struct lock* lock) {
   ASSERT(cond != NULL);
   ASSERT(lock != NULL);
 
-  while (!list_empty(&cond->waiters))
+  while (!rb_empty(&cond->waiters))
     cond_signal(cond, lock);
 }
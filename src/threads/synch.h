@@ -2,12 +2,13 @@
 #define THREADS_SYNCH_H
 
 #include <list.h>
+#include <rbtree.h>
 #include <stdbool.h>
 
 /* A counting semaphore. */
 struct semaphore {
-  unsigned value;      /* Current value. */
-  struct list waiters; /* List of waiting threads. */
+  unsigned value;         /* Current value. */
+  struct rb_tree waiters; /* Waiting threads, in wakeup order. */
 };
 
 void sema_init(struct semaphore*, unsigned value);
@@ -20,6 +21,8 @@ void sema_self_test(void);
 struct lock {
   struct thread* holder;      /* Thread holding lock (for debugging). */
   struct semaphore semaphore; /* Binary semaphore controlling access. */
+  struct rb_tree donors;      /* Waiting threads, highest priority first. */
+  struct rb_elem held_elem;   /* Element in holder's held_locks tree. */
 };
 
 void lock_init(struct lock*);
@@ -28,9 +31,14 @@ bool lock_try_acquire(struct lock*);
 void lock_release(struct lock*);
 bool lock_held_by_current_thread(const struct lock*);
 
+/* Priority donation. */
+void lock_donation_init(struct thread*);
+int lock_donated_priority(const struct thread*);
+void synch_requeue_waiter(struct thread*);
+
 /* Condition variable. */
 struct condition {
-  struct list waiters; /* List of waiting threads. */
+  struct rb_tree waiters; /* Waiting threads, in wakeup order. */
 };
 
 void cond_init(struct condition*);
@@ -2,6 +2,7 @@
 #include <debug.h>
 #include <stddef.h>
 #include <random.h>
+#include <round.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/flags.h"
@@ -10,7 +11,9 @@
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -24,13 +27,39 @@
    that are ready to run but not actually running. */
 static struct list fifo_ready_list;
 
+/* Ready queues for SCHED_PRIO, one FIFO list per priority level.
+   Bit N of prio_ready_bitmap is set iff prio_ready_queues[N] is
+   nonempty, so the highest ready priority is found with a single
+   bit scan instead of a walk over every ready thread. */
+static struct list prio_ready_queues[PRI_MAX + 1];
+static uint64_t prio_ready_bitmap;
+static unsigned prio_ready_cnt; /* # of threads in prio_ready_queues. */
+
+/* Ready tree for SCHED_FAIR, ordered by vruntime, so the thread
+   that has received the least weighted CPU time is leftmost. */
+static struct rb_tree fair_ready_tree;
+
+/* Ready tree for SCHED_STRIDE, ordered by pass, so the thread
+   that is furthest behind its share is leftmost.  Like
+   fair_ready_tree, it links threads through their own struct
+   thread, so any number of threads can be ready at once. */
+static struct rb_tree stride_ready_tree;
+
+/* Ready heap for deadline threads under SCHED_EDF.  Runnable
+   deadline threads wait here, ordered by deadline, and run ahead
+   of everything in prio_ready_queues.  Those that have used up
+   their budget instead wait on their dl_timer for the end of
+   their period, when their budget is replenished.  Admission
+   control caps the number of deadline threads at EDF_THREADS_MAX,
+   so the heap never fills. */
+#define EDF_THREADS_MAX 64
+static struct heap edf_ready_heap;
+static struct heap_elem* edf_ready_slots[EDF_THREADS_MAX];
+
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
-// List of threads waiting for timer.
-extern struct list timer_wait_list;
-
 /* Idle thread. */
 static struct thread* idle_thread;
 
@@ -40,6 +69,17 @@ static struct thread* initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
+/* Pages of exited threads, kept for reuse by thread_create() to
+   spare it a trip through the page allocator.  A thread's page
+   never needs zeroing as a whole, because init_thread() clears
+   struct thread and thread_create() writes every stack frame the
+   new thread starts from.  palloc_get_multiple() drains the
+   cache when the kernel pool runs out.  Accessed with interrupts
+   off. */
+#define THREAD_PAGE_CACHE_MAX 16
+static void* thread_page_cache[THREAD_PAGE_CACHE_MAX];
+static size_t thread_page_cache_cnt;
+
 /* Stack frame for kernel_thread(). */
 struct kernel_thread_frame {
   void* eip;             /* Return address. */
@@ -55,13 +95,138 @@ static long long user_ticks;   /* # of timer ticks in user programs. */
 /* Scheduling. */
 #define TIME_SLICE 4          /* # of timer ticks to give each thread. */
 static unsigned thread_ticks; /* # of timer ticks since last yield. */
+static unsigned thread_cnt;   /* # of threads in all_list. */
+
+/* Multi-level feedback queue scheduler.
+
+   load_avg is updated once a second from prio_ready_cnt, and only
+   the running thread's recent_cpu is charged each tick.  The
+   once-a-second decay of every other thread's recent_cpu is not
+   done in one pass: mlfqs_epoch counts decays, each thread records
+   the epoch it has caught up to, and a sweep over all_list brings
+   a chunk of threads up to date on each of the MLFQS_SWEEP_TICKS
+   ticks that follow the start of an epoch.  Spreading the sweep
+   over the whole decay period keeps the work per tick at
+   thread_cnt / TIMER_FREQ threads.  Threads that become ready or
+   run before the sweep reaches them catch up on the spot, and a
+   sweep left unfinished because ticks were skipped is finished
+   before the next epoch starts, so no thread ever lags more than
+   one epoch. */
+#define MLFQS_SWEEP_TICKS TIMER_FREQ   /* # of ticks to spread a sweep over. */
+static fixed_point_t load_avg;         /* System load average. */
+static fixed_point_t recent_cpu_decay; /* Decay factor for the current epoch. */
+static int64_t mlfqs_epoch;            /* # of recent_cpu decays so far. */
+static struct list_elem* mlfqs_sweep;  /* Next all_list element to catch up. */
+static unsigned mlfqs_sweep_batch;     /* # of threads to catch up per tick. */
+
+/* Fair scheduler.
+
+   Each thread's vruntime advances on every tick it runs by an
+   amount inversely proportional to its weight, which grows by
+   10% per priority level, and the scheduler always runs the
+   thread with the least vruntime.  A thread at PRI_MIN thus still
+   gets about 1/400 of the CPU share of one at PRI_MAX instead of
+   starving.  Rather than a fixed TIME_SLICE, every ready thread
+   runs once per FAIR_LATENCY ticks, stretched to
+   FAIR_MIN_GRANULARITY ticks per thread when many are ready, and
+   gets a share of that period proportional to its weight.
+
+   min_vruntime only moves forward and tracks the least vruntime
+   of any runnable thread.  Threads that wake up are placed no
+   further back than half a period behind it, so a long sleep
+   earns a little latency credit but not a burst that locks out
+   everyone else, and a woken thread that is more than
+   FAIR_WAKEUP_GRANULARITY behind the running thread preempts it
+   at the next tick. */
+#define FAIR_LATENCY 8                        /* Target scheduling period, in ticks. */
+#define FAIR_MIN_GRANULARITY 1                /* Minimum slice, in ticks. */
+#define FAIR_WEIGHT_DEFAULT 1024              /* Weight at PRI_DEFAULT. */
+#define FAIR_TICK_VRUNTIME ((uint64_t)1 << 20) /* vruntime of one tick at default weight. */
+#define FAIR_WAKEUP_GRANULARITY FAIR_TICK_VRUNTIME
+#define FAIR_SLEEPER_CREDIT (FAIR_LATENCY * FAIR_TICK_VRUNTIME / 2)
+
+/* Weight of each priority level, round(1024 * 1.1**(p - 31)). */
+static const uint32_t fair_weights[PRI_MAX + 1] = {
+    53,    59,    65,    71,    78,    86,    95,    104,   /* 0..7 */
+    114,   126,   138,   152,   167,   184,   203,   223,   /* 8..15 */
+    245,   270,   297,   326,   359,   395,   434,   478,   /* 16..23 */
+    525,   578,   636,   699,   769,   846,   931,   1024,  /* 24..31 */
+    1126,  1239,  1363,  1499,  1649,  1814,  1995,  2195,  /* 32..39 */
+    2415,  2656,  2922,  3214,  3535,  3889,  4278,  4705,  /* 40..47 */
+    5176,  5693,  6263,  6889,  7578,  8336,  9169,  10086, /* 48..55 */
+    11095, 12204, 13425, 14767, 16244, 17868, 19655, 21621, /* 56..63 */
+};
+
+static uint64_t fair_min_vruntime; /* Least vruntime of any runnable thread. */
+static uint32_t fair_load;         /* Sum of the weights of ready threads. */
+
+/* Stride scheduler.
+
+   Each thread's stride is inversely proportional to its tickets,
+   and its pass advances by one stride for every tick it runs.
+   The running thread is preempted as soon as a ready thread has
+   a smaller pass, so each quantum of one tick goes to the thread
+   with the least pass and, over any interval, every thread that
+   stays runnable receives CPU time in proportion to its tickets
+   to within a quantum.  Ties are broken by tid, which makes the
+   schedule deterministic.
+
+   stride_global_pass only moves forward and tracks the least
+   pass of any runnable thread.  A thread that wakes up is moved
+   up to it, so time spent blocked is not banked as credit. */
+#define STRIDE1 ((uint64_t)1 << 20) /* Stride of a thread holding one ticket. */
+static uint64_t stride_global_pass; /* Least pass of any runnable thread. */
+
+/* Earliest-deadline-first scheduler.
+
+   A deadline thread asks for DL_RUNTIME ticks of CPU time in
+   every DL_PERIOD ticks, and is admitted only if the sum of
+   runtime / period over all deadline threads stays at or below 1,
+   which is exactly the condition under which EDF meets every
+   deadline.  Each tick a deadline thread runs is charged to its
+   budget, and once the budget is gone it is throttled until its
+   period ends, so an overrunning thread cannot take time that was
+   reserved for the others.  A thread that wakes up keeps its
+   current deadline only if its remaining budget fits in the
+   remaining time at its reserved rate; otherwise it starts a new
+   period at once, as in a constant bandwidth server.  Threads
+   without a deadline are scheduled by strict priority whenever
+   no deadline thread is runnable. */
+#define EDF_UTIL_SCALE ((uint32_t)1 << 20) /* Utilization of a thread that never sleeps. */
+static uint32_t edf_util;                  /* Sum of dl_util over all deadline threads. */
+static unsigned edf_thread_cnt;            /* # of deadline threads. */
 
 static void init_thread(struct thread*, const char* name, int priority);
 static bool is_thread(struct thread*) UNUSED;
 static void* alloc_frame(struct thread*, size_t size);
 static void schedule(void);
 static void thread_enqueue(struct thread* t);
+static void prio_queue_push(struct thread* t);
+static void prio_queue_remove(struct thread* t);
+static int prio_queue_max(void);
+static struct thread* prio_queue_pop(void);
+static bool uses_prio_queues(void);
+static void mlfqs_tick(struct thread* cur, int64_t cur_tick);
+static void mlfqs_catch_up(struct thread* t);
+static void mlfqs_update_priority(struct thread* t);
+static bool fair_less(const struct rb_elem* a, const struct rb_elem* b, void* aux UNUSED);
+static uint32_t fair_weight(const struct thread* t);
+static void fair_enqueue(struct thread* t);
+static void fair_update_min_vruntime(struct thread* cur);
+static void fair_tick(struct thread* cur);
+static bool stride_less(const struct rb_elem* a, const struct rb_elem* b, void* aux UNUSED);
+static void stride_enqueue(struct thread* t);
+static void stride_tick(struct thread* cur);
+static bool is_deadline_thread(const struct thread* t);
+static bool edf_less(const struct heap_elem* a, const struct heap_elem* b, void* aux UNUSED);
+static void edf_replenish(struct thread* t, int64_t now);
+static void edf_enqueue(struct thread* t);
+static bool edf_should_preempt(struct thread* cur);
+static void edf_unthrottle(void* t_);
+static void edf_tick(struct thread* cur);
 static tid_t allocate_tid(void);
+static void* thread_page_get(void);
+static void thread_page_put(void* page);
 void thread_switch_tail(struct thread* prev);
 
 static void kernel_thread(thread_func*, void* aux);
@@ -73,12 +238,14 @@ static struct thread* thread_schedule_fifo(void);
 static struct thread* thread_schedule_prio(void);
 static struct thread* thread_schedule_fair(void);
 static struct thread* thread_schedule_mlfqs(void);
+static struct thread* thread_schedule_stride(void);
+static struct thread* thread_schedule_edf(void);
 static struct thread* thread_schedule_reserved(void);
 
 /* Determines which scheduler the kernel should use.
    Controlled by the kernel command-line options
     "-sched=fifo", "-sched=prio",
-    "-sched=fair". "-sched=mlfqs"
+    "-sched=fair". "-sched=mlfqs", "-sched=stride", "-sched=edf"
    Is equal to SCHED_FIFO by default. */
 enum sched_policy active_sched_policy;
 
@@ -90,7 +257,7 @@ typedef struct thread* scheduler_func(void);
    policy in use by the kernel. */
 scheduler_func* scheduler_jump_table[8] = {thread_schedule_fifo,     thread_schedule_prio,
                                            thread_schedule_fair,     thread_schedule_mlfqs,
-                                           thread_schedule_reserved, thread_schedule_reserved,
+                                           thread_schedule_stride,   thread_schedule_edf,
                                            thread_schedule_reserved, thread_schedule_reserved};
 
 /* Initializes the threading system by transforming the code
@@ -111,7 +278,19 @@ void thread_init(void) {
 
   lock_init(&tid_lock);
   list_init(&fifo_ready_list);
-  //   list_init(&timer_wait_list);
+  for (int i = PRI_MIN; i <= PRI_MAX; i++)
+    list_init(&prio_ready_queues[i]);
+  prio_ready_bitmap = 0;
+  prio_ready_cnt = 0;
+  mlfqs_sweep = NULL;
+  rb_init(&fair_ready_tree, fair_less, NULL);
+  fair_min_vruntime = 0;
+  fair_load = 0;
+  rb_init(&stride_ready_tree, stride_less, NULL);
+  stride_global_pass = 0;
+  heap_init(&edf_ready_heap, edf_ready_slots, EDF_THREADS_MAX, edf_less, NULL);
+  edf_util = 0;
+  edf_thread_cnt = 0;
   list_init(&all_list);
 
   /* Set up a thread structure for the running thread. */
@@ -151,26 +330,17 @@ void thread_tick(int64_t cur_tick) {
   else
     kernel_ticks++;
 
-  // check for timer expiration
-  while (!list_empty(&timer_wait_list)) {
-    struct list_elem* e = list_front(&timer_wait_list);
-    struct thread* t = list_entry(e, struct thread, elem);
-    if (t->wakeup_time <= cur_tick) {
-      list_pop_front(&timer_wait_list);
-      thread_unblock(t);
-
-      if (t->eff_priority > thread_current()->eff_priority) {
-        // yield if a thread with higher priority came off timer
-        intr_yield_on_return();
-      }
-
-    } else {
-      break;
-    }
-  }
+  if (active_sched_policy == SCHED_MLFQS)
+    mlfqs_tick(t, cur_tick);
+  else if (active_sched_policy == SCHED_EDF)
+    edf_tick(t);
 
   /* Enforce preemption. */
-  if (++thread_ticks >= TIME_SLICE)
+  if (active_sched_policy == SCHED_FAIR)
+    fair_tick(t);
+  else if (active_sched_policy == SCHED_STRIDE)
+    stride_tick(t);
+  else if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return();
 }
 
@@ -178,6 +348,7 @@ void thread_tick(int64_t cur_tick) {
 void thread_print_stats(void) {
   printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks, kernel_ticks,
          user_ticks);
+  schedstat_print();
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -205,13 +376,27 @@ tid_t thread_create(const char* name, int priority, thread_func* function, void*
   ASSERT(function != NULL);
 
   /* Allocate thread. */
-  t = palloc_get_page(PAL_ZERO);
+  t = thread_page_get();
   if (t == NULL)
     return TID_ERROR;
 
   /* Initialize thread. */
   init_thread(t, name, priority);
   tid = t->tid = allocate_tid();
+  schedstat_attach(t);
+
+  /* Children inherit the MLFQS state of their creator, which
+     replaces PRIORITY under that policy, and its tickets. */
+  struct thread* cur = thread_current();
+  enum intr_level old_level = intr_disable();
+  if (active_sched_policy == SCHED_MLFQS)
+    mlfqs_catch_up(cur);
+  t->nice = cur->nice;
+  t->recent_cpu = cur->recent_cpu;
+  t->tickets = cur->tickets;
+  if (active_sched_policy == SCHED_MLFQS)
+    mlfqs_update_priority(t);
+  intr_set_level(old_level);
 
   /* Stack frame for kernel_thread(). */
   kf = alloc_frame(t, sizeof *kf);
@@ -228,11 +413,6 @@ tid_t thread_create(const char* name, int priority, thread_func* function, void*
   sf->eip = switch_entry;
   sf->ebp = 0;
 
-  struct switch_threads_frame* tmp = sf;
-  uint8_t fpu[108];
-
-  asm volatile("fsave (%0); fninit; fsave (%1); frstor (%0)" : : "g"(fpu), "g"(&tmp->fpu));
-  //   asm volatile("fninit; fsave (%0)" : : "g"(&tmp->fpu));
   // t->pcb = thread_current()->pcb;
   /* Add to run queue. */
   thread_unblock(t);
@@ -256,6 +436,7 @@ void thread_block(void) {
   ASSERT(!intr_context());
   ASSERT(intr_get_level() == INTR_OFF);
 
+  trace_event(TRACE_THREAD_BLOCK, 0);
   thread_current()->status = THREAD_BLOCKED;
   schedule();
 }
@@ -268,11 +449,23 @@ static void thread_enqueue(struct thread* t) {
   ASSERT(intr_get_level() == INTR_OFF);
   ASSERT(is_thread(t));
 
+  schedstat_ready(t);
   if (active_sched_policy == SCHED_FIFO) {
     list_push_back(&fifo_ready_list, &t->elem);
   } else if (active_sched_policy == SCHED_PRIO) {
-    list_push_back(&fifo_ready_list, &t->elem);
-    // list_insert_ordered(&fifo_ready_list, &t->elem, )
+    prio_queue_push(t);
+  } else if (active_sched_policy == SCHED_FAIR) {
+    fair_enqueue(t);
+  } else if (active_sched_policy == SCHED_MLFQS) {
+    mlfqs_catch_up(t);
+    prio_queue_push(t);
+  } else if (active_sched_policy == SCHED_STRIDE) {
+    stride_enqueue(t);
+  } else if (active_sched_policy == SCHED_EDF) {
+    if (is_deadline_thread(t))
+      edf_enqueue(t);
+    else
+      prio_queue_push(t);
   } else {
     PANIC("Unimplemented scheduling policy value: %d", active_sched_policy);
   }
@@ -293,6 +486,7 @@ void thread_unblock(struct thread* t) {
 
   old_level = intr_disable();
   ASSERT(t->status == THREAD_BLOCKED);
+  trace_event(TRACE_THREAD_UNBLOCK, t->tid);
   thread_enqueue(t);
   t->status = THREAD_READY;
   intr_set_level(old_level);
@@ -300,6 +494,24 @@ void thread_unblock(struct thread* t) {
   // TODO: check if unblocked thread has greater priority than currently running thread, if so call schedule
 }
 
+/* Unblocks T, which was sleeping in timer_sleep(), from the timer
+   softirq, and preempts the running thread on return from the
+   interrupt if T should run first. */
+void thread_wakeup(struct thread* t) {
+  ASSERT(intr_context());
+
+  thread_unblock(t);
+
+  if (active_sched_policy != SCHED_FAIR && active_sched_policy != SCHED_STRIDE &&
+      t->eff_priority > thread_current()->eff_priority) {
+    // yield if a thread with higher priority came off timer
+    intr_yield_on_return();
+  } else if (active_sched_policy == SCHED_EDF && edf_should_preempt(thread_current())) {
+    // or if a deadline thread that should run first came off timer
+    intr_yield_on_return();
+  }
+}
+
 /* Returns the name of the running thread. */
 const char* thread_name(void) { return thread_current()->name; }
 
@@ -328,11 +540,21 @@ tid_t thread_tid(void) { return thread_current()->tid; }
 void thread_exit(void) {
   ASSERT(!intr_context());
 
+  schedstat_detach(thread_current());
+
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it calls thread_switch_tail(). */
   intr_disable();
+  if (mlfqs_sweep == &thread_current()->allelem)
+    mlfqs_sweep = list_next(mlfqs_sweep);
+  if (is_deadline_thread(thread_current())) {
+    edf_util -= thread_current()->dl_util;
+    edf_thread_cnt--;
+  }
+  fpu_release(thread_current());
   list_remove(&thread_current()->allelem);
+  thread_cnt--;
   thread_current()->status = THREAD_DYING;
   schedule();
   NOT_REACHED();
@@ -367,49 +589,179 @@ void thread_foreach(thread_action_func* func, void* aux) {
   }
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Sets the current thread's priority to NEW_PRIORITY.  Has no
+   effect under SCHED_MLFQS, which computes priorities itself. */
 void thread_set_priority(int new_priority) {
+  if (active_sched_policy == SCHED_MLFQS)
+    return;
 
   enum intr_level old_level = intr_disable();
 
   struct thread* t = thread_current();
+  int donated = lock_donated_priority(t);
   t->priority = new_priority;
-  if (list_empty(&t->gotten_prio_list) || t->eff_priority < new_priority) {
-    // if no donations or new base priority is higher than current,
-    // set effective priority to new value
-    t->eff_priority = new_priority;
-  }
+  thread_set_eff_priority(t, donated > new_priority ? donated : new_priority);
 
-  struct thread* tmp = max_thread_from_list(&fifo_ready_list);
-  if (tmp != NULL && tmp->eff_priority > t->eff_priority) {
+  if (thread_ready_max_priority() > t->eff_priority) {
     thread_yield();
   }
   intr_set_level(old_level);
 }
 
+/* Sets thread T's effective priority to EFF_PRIORITY.  If T is
+   sitting in a priority ready queue it is moved to the tail of
+   the queue for its new level, so that donation takes effect at
+   the next scheduling decision.  If T is in the fair ready tree
+   its position is unchanged, but its weight counts toward the
+   ready load at the new level.  If T is waiting on a semaphore or
+   condition variable, it moves to its new place among the
+   waiters.
+
+   This function must be called with interrupts turned off. */
+void thread_set_eff_priority(struct thread* t, int64_t eff_priority) {
+  ASSERT(intr_get_level() == INTR_OFF);
+  ASSERT(is_thread(t));
+
+  if (t->eff_priority == eff_priority)
+    return;
+  if (t->status == THREAD_READY && uses_prio_queues() && t != idle_thread &&
+      !is_deadline_thread(t)) {
+    prio_queue_remove(t);
+    t->eff_priority = eff_priority;
+    prio_queue_push(t);
+  } else if (t->status == THREAD_READY && active_sched_policy == SCHED_FAIR &&
+             t != idle_thread) {
+    fair_load -= fair_weight(t);
+    t->eff_priority = eff_priority;
+    fair_load += fair_weight(t);
+  } else
+    t->eff_priority = eff_priority;
+  synch_requeue_waiter(t);
+}
+
+/* Returns the highest effective priority of any thread in the
+   ready structure, or PRI_MIN - 1 if no thread is ready. */
+int thread_ready_max_priority(void) {
+  if (uses_prio_queues())
+    return prio_queue_max();
+
+  struct thread* t = max_thread_from_list(&fifo_ready_list);
+  return t != NULL ? t->eff_priority : PRI_MIN - 1;
+}
+
 /* Returns the current thread's priority. */
 int thread_get_priority(void) { return thread_current()->eff_priority; }
 
-/* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED) { /* Not yet implemented. */
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority, yielding if it no longer has the highest. */
+void thread_set_nice(int nice) {
+  ASSERT(NICE_MIN <= nice && nice <= NICE_MAX);
+
+  enum intr_level old_level = intr_disable();
+  struct thread* t = thread_current();
+  t->nice = nice;
+  if (active_sched_policy == SCHED_MLFQS) {
+    mlfqs_catch_up(t);
+    mlfqs_update_priority(t);
+    if (thread_ready_max_priority() > t->eff_priority)
+      thread_yield();
+  }
+  intr_set_level(old_level);
 }
 
 /* Returns the current thread's nice value. */
-int thread_get_nice(void) {
-  /* Not yet implemented. */
-  return 0;
-}
+int thread_get_nice(void) { return thread_current()->nice; }
 
 /* Returns 100 times the system load average. */
 int thread_get_load_avg(void) {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable();
+  int load = fix_round(fix_scale(load_avg, 100));
+  intr_set_level(old_level);
+  return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int thread_get_recent_cpu(void) {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable();
+  struct thread* t = thread_current();
+  mlfqs_catch_up(t);
+  int recent_cpu = fix_round(fix_scale(t->recent_cpu, 100));
+  intr_set_level(old_level);
+  return recent_cpu;
+}
+
+/* Sets the current thread's tickets to TICKETS, which takes
+   effect from its next quantum under SCHED_STRIDE. */
+void thread_set_tickets(int tickets) {
+  ASSERT(TICKETS_MIN <= tickets && tickets <= TICKETS_MAX);
+
+  enum intr_level old_level = intr_disable();
+  thread_current()->tickets = tickets;
+  intr_set_level(old_level);
+}
+
+/* Returns the current thread's tickets. */
+int thread_get_tickets(void) { return thread_current()->tickets; }
+
+/* Makes the current thread a deadline thread that needs RUNTIME
+   ticks of CPU time in every PERIOD ticks, with its first period
+   starting now, or returns it to strict-priority scheduling if
+   PERIOD is 0.  Returns false, leaving the thread unchanged, if
+   the policy is not SCHED_EDF, if RUNTIME is not between 1 and
+   PERIOD, or if admitting the thread would raise total
+   utilization above 1. */
+bool thread_set_deadline(int64_t period, int64_t runtime) {
+  struct thread* t = thread_current();
+  uint32_t util = 0;
+
+  if (active_sched_policy != SCHED_EDF)
+    return false;
+  if (period != 0) {
+    if (period < 0 || runtime < 1 || runtime > period)
+      return false;
+    util = DIV_ROUND_UP((uint64_t)runtime * EDF_UTIL_SCALE, period);
+  }
+
+  enum intr_level old_level = intr_disable();
+  bool was_deadline = is_deadline_thread(t);
+  unsigned dl_cnt = edf_thread_cnt - was_deadline + (period != 0);
+  uint32_t total_util = edf_util - t->dl_util + util;
+  if (dl_cnt > EDF_THREADS_MAX || total_util > EDF_UTIL_SCALE) {
+    intr_set_level(old_level);
+    return false;
+  }
+
+  edf_thread_cnt = dl_cnt;
+  edf_util = total_util;
+  t->dl_period = period;
+  t->dl_runtime = runtime;
+  t->dl_util = util;
+  t->dl_throttled = false;
+  timer_setup(&t->dl_timer, edf_unthrottle, t);
+  if (period != 0) {
+    t->dl_deadline = timer_ticks() + period;
+    t->dl_budget = runtime;
+  }
+
+  /* Let whichever thread now comes first run. */
+  thread_yield();
+  intr_set_level(old_level);
+  return true;
+}
+
+/* Gives up the rest of the current deadline thread's budget, so
+   that it next runs when its following period begins.  A
+   periodic thread calls this once its work for a period is done.
+   Other threads just yield. */
+void thread_deadline_yield(void) {
+  enum intr_level old_level = intr_disable();
+  struct thread* t = thread_current();
+  if (is_deadline_thread(t)) {
+    t->dl_budget = 0;
+    t->dl_throttled = true;
+  }
+  thread_yield();
+  intr_set_level(old_level);
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -442,7 +794,11 @@ static void idle(void* idle_started_ UNUSED) {
          time.
 
          See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-         7.11.1 "HLT Instruction". */
+         7.11.1 "HLT Instruction".
+
+       First stop the timer tick, if nothing needs it for a while
+       and tickless idle is enabled. */
+    timer_tickless_enter();
     asm volatile("sti; hlt" : : : "memory");
   }
 }
@@ -487,13 +843,19 @@ static void init_thread(struct thread* t, const char* name, int priority) {
   t->priority = priority;
   t->eff_priority = priority;
   t->is_exiting = false;
-  list_init(&t->gotten_prio_list);
-  t->waiting_lock = NULL;
+  lock_donation_init(t);
   t->pcb = NULL;
+  t->nice = NICE_DEFAULT;
+  t->recent_cpu = fix_int(0);
+  t->tickets = TICKETS_DEFAULT;
   t->magic = THREAD_MAGIC;
 
   old_level = intr_disable();
+  t->mlfqs_epoch = mlfqs_epoch;
+  t->vruntime = fair_min_vruntime;
+  t->pass = stride_global_pass;
   list_push_back(&all_list, &t->allelem);
+  thread_cnt++;
   intr_set_level(old_level);
 }
 
@@ -530,23 +892,370 @@ struct thread* max_thread_from_list(struct list* l) {
   return t_max;
 }
 
-/* Strict priority scheduler */
-static struct thread* thread_schedule_prio(void) {
-  struct thread* t_max = max_thread_from_list(&fifo_ready_list);
-  if (t_max == NULL)
+/* Appends T to the ready queue for its effective priority and
+   marks that level as occupied. */
+static void prio_queue_push(struct thread* t) {
+  ASSERT(PRI_MIN <= t->eff_priority && t->eff_priority <= PRI_MAX);
+
+  list_push_back(&prio_ready_queues[t->eff_priority], &t->elem);
+  prio_ready_bitmap |= (uint64_t)1 << t->eff_priority;
+  prio_ready_cnt++;
+}
+
+/* Removes T from the ready queue for its effective priority,
+   clearing that level's bit if the queue becomes empty. */
+static void prio_queue_remove(struct thread* t) {
+  list_remove(&t->elem);
+  if (list_empty(&prio_ready_queues[t->eff_priority]))
+    prio_ready_bitmap &= ~((uint64_t)1 << t->eff_priority);
+  prio_ready_cnt--;
+}
+
+/* Returns the highest nonempty priority level, or PRI_MIN - 1 if
+   every ready queue is empty.  The 64-bit bitmap is scanned as
+   two words with BSR, see [IA32-v2a] "BSR". */
+static int prio_queue_max(void) {
+  uint32_t hi = prio_ready_bitmap >> 32;
+  uint32_t lo = prio_ready_bitmap;
+  uint32_t bit;
+
+  if (hi != 0) {
+    asm("bsrl %1, %0" : "=r"(bit) : "rm"(hi));
+    return 32 + bit;
+  } else if (lo != 0) {
+    asm("bsrl %1, %0" : "=r"(bit) : "rm"(lo));
+    return bit;
+  }
+  return PRI_MIN - 1;
+}
+
+/* Removes and returns the thread at the front of the highest
+   nonempty ready queue, or idle_thread if all are empty. */
+static struct thread* prio_queue_pop(void) {
+  int level = prio_queue_max();
+  if (level < PRI_MIN)
     return idle_thread;
-  list_remove(&t_max->elem);
+
+  struct thread* t_max = list_entry(list_front(&prio_ready_queues[level]), struct thread, elem);
+  prio_queue_remove(t_max);
   return t_max;
 }
 
+/* Returns true if the active policy keeps ready threads in
+   prio_ready_queues. */
+static bool uses_prio_queues(void) {
+  return active_sched_policy == SCHED_PRIO || active_sched_policy == SCHED_MLFQS ||
+         active_sched_policy == SCHED_EDF;
+}
+
+/* Strict priority scheduler */
+static struct thread* thread_schedule_prio(void) { return prio_queue_pop(); }
+
 /* Fair priority scheduler */
 static struct thread* thread_schedule_fair(void) {
-  PANIC("Unimplemented scheduler policy: \"-sched=fair\"");
+  struct rb_elem* e = rb_min(&fair_ready_tree);
+  if (e == NULL)
+    return idle_thread;
+
+  struct thread* t = rb_entry(e, struct thread, fair_elem);
+  rb_remove(&fair_ready_tree, e);
+  fair_load -= fair_weight(t);
+  return t;
+}
+
+/* Orders threads in fair_ready_tree by vruntime. */
+static bool fair_less(const struct rb_elem* a, const struct rb_elem* b, void* aux UNUSED) {
+  return rb_entry(a, struct thread, fair_elem)->vruntime <
+         rb_entry(b, struct thread, fair_elem)->vruntime;
+}
+
+/* Returns thread T's scheduling weight under SCHED_FAIR, which
+   follows its effective priority so that donation also lends
+   CPU share. */
+static uint32_t fair_weight(const struct thread* t) {
+  ASSERT(PRI_MIN <= t->eff_priority && t->eff_priority <= PRI_MAX);
+  return fair_weights[t->eff_priority];
+}
+
+/* Inserts T into fair_ready_tree.  A thread that is waking up,
+   rather than yielding, is first moved up to within
+   FAIR_SLEEPER_CREDIT of min_vruntime. */
+static void fair_enqueue(struct thread* t) {
+  if (t->status == THREAD_BLOCKED) {
+    uint64_t floor =
+        fair_min_vruntime > FAIR_SLEEPER_CREDIT ? fair_min_vruntime - FAIR_SLEEPER_CREDIT : 0;
+    if (t->vruntime < floor)
+      t->vruntime = floor;
+  }
+  rb_insert(&fair_ready_tree, &t->fair_elem);
+  fair_load += fair_weight(t);
+}
+
+/* Advances min_vruntime to the least vruntime of the running
+   thread CUR, if it is not idle, and the ready threads. */
+static void fair_update_min_vruntime(struct thread* cur) {
+  struct rb_elem* e = rb_min(&fair_ready_tree);
+  uint64_t vruntime = UINT64_MAX;
+
+  if (cur != idle_thread)
+    vruntime = cur->vruntime;
+  if (e != NULL) {
+    uint64_t leftmost = rb_entry(e, struct thread, fair_elem)->vruntime;
+    if (leftmost < vruntime)
+      vruntime = leftmost;
+  }
+  if (vruntime != UINT64_MAX && vruntime > fair_min_vruntime)
+    fair_min_vruntime = vruntime;
+}
+
+/* Per-tick SCHED_FAIR bookkeeping for the running thread CUR,
+   called from thread_tick() in an external interrupt context.
+   Charges CUR for the tick and preempts it once it has used up
+   its share of the period, or as soon as a ready thread is far
+   enough behind it. */
+static void fair_tick(struct thread* cur) {
+  if (cur == idle_thread) {
+    if (!rb_empty(&fair_ready_tree))
+      intr_yield_on_return();
+    return;
+  }
+
+  uint32_t weight = fair_weight(cur);
+  cur->vruntime += FAIR_TICK_VRUNTIME * FAIR_WEIGHT_DEFAULT / weight;
+  fair_update_min_vruntime(cur);
+
+  struct rb_elem* e = rb_min(&fair_ready_tree);
+  if (e == NULL)
+    return;
+
+  /* Slice is CUR's weighted share of the period, which stretches
+     to give each ready thread at least FAIR_MIN_GRANULARITY. */
+  unsigned nr_running = rb_size(&fair_ready_tree) + 1;
+  unsigned period = FAIR_LATENCY;
+  if (nr_running * FAIR_MIN_GRANULARITY > period)
+    period = nr_running * FAIR_MIN_GRANULARITY;
+  unsigned slice = (uint64_t)period * weight / (fair_load + weight);
+  if (slice < FAIR_MIN_GRANULARITY)
+    slice = FAIR_MIN_GRANULARITY;
+
+  struct thread* leftmost = rb_entry(e, struct thread, fair_elem);
+  if (++thread_ticks >= slice || leftmost->vruntime + FAIR_WAKEUP_GRANULARITY < cur->vruntime)
+    intr_yield_on_return();
 }
 
 /* Multi-level feedback queue scheduler */
-static struct thread* thread_schedule_mlfqs(void) {
-  PANIC("Unimplemented scheduler policy: \"-sched=mlfqs\"");
+static struct thread* thread_schedule_mlfqs(void) { return prio_queue_pop(); }
+
+/* Per-tick MLFQS bookkeeping for the running thread CUR, called
+   from thread_tick() in an external interrupt context. */
+static void mlfqs_tick(struct thread* cur, int64_t cur_tick) {
+  if (cur != idle_thread)
+    cur->recent_cpu = fix_add(cur->recent_cpu, fix_int(1));
+
+  if (cur_tick % TIMER_FREQ == 0) {
+    /* Threads still waiting for the last sweep must catch up
+       with the old decay factor. */
+    for (; mlfqs_sweep != NULL && mlfqs_sweep != list_end(&all_list);
+         mlfqs_sweep = list_next(mlfqs_sweep))
+      mlfqs_catch_up(list_entry(mlfqs_sweep, struct thread, allelem));
+
+    /* Start a new epoch.  The ready count is maintained by the
+       ready queues, so this does not walk any list. */
+    int ready = prio_ready_cnt + (cur != idle_thread);
+    load_avg = fix_add(fix_mul(fix_frac(59, 60), load_avg), fix_frac(ready, 60));
+
+    fixed_point_t twice_load = fix_scale(load_avg, 2);
+    recent_cpu_decay = fix_div(twice_load, fix_add(twice_load, fix_int(1)));
+    mlfqs_epoch++;
+
+    mlfqs_sweep = list_begin(&all_list);
+    mlfqs_sweep_batch = DIV_ROUND_UP(thread_cnt, MLFQS_SWEEP_TICKS);
+  }
+
+  mlfqs_catch_up(cur);
+  if (cur != idle_thread)
+    mlfqs_update_priority(cur);
+
+  /* Catch up the next chunk of the sweep. */
+  for (unsigned i = 0; mlfqs_sweep != NULL && i < mlfqs_sweep_batch; i++) {
+    if (mlfqs_sweep == list_end(&all_list)) {
+      mlfqs_sweep = NULL;
+      break;
+    }
+    struct thread* t = list_entry(mlfqs_sweep, struct thread, allelem);
+    mlfqs_sweep = list_next(mlfqs_sweep);
+    mlfqs_catch_up(t);
+  }
+
+  if (thread_ready_max_priority() > cur->eff_priority)
+    intr_yield_on_return();
+}
+
+/* Applies any recent_cpu decay that thread T has missed since its
+   last update and recomputes its priority.  The sweep started by
+   each epoch finishes before the next one, so the loop runs at
+   most once.
+
+   This function must be called with interrupts turned off. */
+static void mlfqs_catch_up(struct thread* t) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  if (t->mlfqs_epoch == mlfqs_epoch)
+    return;
+  while (t->mlfqs_epoch < mlfqs_epoch) {
+    t->recent_cpu = fix_add(fix_mul(recent_cpu_decay, t->recent_cpu), fix_int(t->nice));
+    t->mlfqs_epoch++;
+  }
+  mlfqs_update_priority(t);
+}
+
+/* Sets T's priority to PRI_MAX - (recent_cpu / 4) - (nice * 2),
+   clamped to [PRI_MIN, PRI_MAX], moving T between ready queues
+   if necessary. */
+static void mlfqs_update_priority(struct thread* t) {
+  int priority =
+      fix_trunc(fix_sub(fix_int(PRI_MAX - t->nice * 2), fix_unscale(t->recent_cpu, 4)));
+  if (priority < PRI_MIN)
+    priority = PRI_MIN;
+  else if (priority > PRI_MAX)
+    priority = PRI_MAX;
+
+  t->priority = priority;
+  thread_set_eff_priority(t, priority);
+}
+
+/* Stride scheduler */
+static struct thread* thread_schedule_stride(void) {
+  struct rb_elem* e = rb_min(&stride_ready_tree);
+  if (e == NULL)
+    return idle_thread;
+
+  rb_remove(&stride_ready_tree, e);
+  return rb_entry(e, struct thread, stride_elem);
+}
+
+/* Orders threads in stride_ready_tree by pass, then by tid. */
+static bool stride_less(const struct rb_elem* a_, const struct rb_elem* b_, void* aux UNUSED) {
+  const struct thread* a = rb_entry(a_, struct thread, stride_elem);
+  const struct thread* b = rb_entry(b_, struct thread, stride_elem);
+
+  return a->pass < b->pass || (a->pass == b->pass && a->tid < b->tid);
+}
+
+/* Inserts T into stride_ready_tree.  A thread that is waking up,
+   rather than yielding, first has its pass moved up to
+   stride_global_pass. */
+static void stride_enqueue(struct thread* t) {
+  if (t->status == THREAD_BLOCKED && t->pass < stride_global_pass)
+    t->pass = stride_global_pass;
+  rb_insert(&stride_ready_tree, &t->stride_elem);
+}
+
+/* Per-tick SCHED_STRIDE bookkeeping for the running thread CUR,
+   called from thread_tick() in an external interrupt context.
+   Charges CUR one stride and preempts it if a ready thread's
+   pass is now smaller. */
+static void stride_tick(struct thread* cur) {
+  struct rb_elem* e = rb_min(&stride_ready_tree);
+  struct thread* next = e != NULL ? rb_entry(e, struct thread, stride_elem) : NULL;
+
+  if (cur == idle_thread) {
+    if (next != NULL)
+      intr_yield_on_return();
+    return;
+  }
+
+  cur->pass += STRIDE1 / cur->tickets;
+
+  uint64_t global_pass = next != NULL && next->pass < cur->pass ? next->pass : cur->pass;
+  if (global_pass > stride_global_pass)
+    stride_global_pass = global_pass;
+
+  if (next != NULL && stride_less(&next->stride_elem, &cur->stride_elem, NULL))
+    intr_yield_on_return();
+}
+
+/* Earliest-deadline-first scheduler */
+static struct thread* thread_schedule_edf(void) {
+  struct heap_elem* e = heap_pop(&edf_ready_heap);
+  return e != NULL ? heap_entry(e, struct thread, dl_elem) : prio_queue_pop();
+}
+
+/* Returns true if T has a deadline under SCHED_EDF. */
+static bool is_deadline_thread(const struct thread* t) { return t->dl_period != 0; }
+
+/* Orders deadline threads by deadline, then by tid. */
+static bool edf_less(const struct heap_elem* a_, const struct heap_elem* b_, void* aux UNUSED) {
+  const struct thread* a = heap_entry(a_, struct thread, dl_elem);
+  const struct thread* b = heap_entry(b_, struct thread, dl_elem);
+
+  return a->dl_deadline < b->dl_deadline || (a->dl_deadline == b->dl_deadline && a->tid < b->tid);
+}
+
+/* Starts a new period for deadline thread T with a full budget,
+   its deadline one period after the later of its old deadline
+   and NOW. */
+static void edf_replenish(struct thread* t, int64_t now) {
+  t->dl_deadline = (t->dl_deadline > now ? t->dl_deadline : now) + t->dl_period;
+  t->dl_budget = t->dl_runtime;
+  t->dl_throttled = false;
+}
+
+/* Inserts deadline thread T into edf_ready_heap, or arms its
+   dl_timer if it is out of budget for the current period. */
+static void edf_enqueue(struct thread* t) {
+  int64_t now = timer_ticks();
+
+  if (t->dl_throttled) {
+    if (t->dl_deadline > now) {
+      timer_add(&t->dl_timer, t->dl_deadline);
+      return;
+    }
+    edf_replenish(t, now);
+  } else if (t->status == THREAD_BLOCKED &&
+             (t->dl_deadline <= now ||
+              t->dl_budget * t->dl_period > (t->dl_deadline - now) * t->dl_runtime)) {
+    /* Waking up too late to finish the current period's budget
+       by its deadline at the reserved rate. */
+    t->dl_deadline = now;
+    edf_replenish(t, now);
+  }
+  heap_push(&edf_ready_heap, &t->dl_elem);
+}
+
+/* Returns true if a ready deadline thread should run instead of
+   CUR. */
+static bool edf_should_preempt(struct thread* cur) {
+  struct heap_elem* e = heap_min(&edf_ready_heap);
+  if (e == NULL)
+    return false;
+  if (cur == idle_thread || !is_deadline_thread(cur) || cur->dl_throttled)
+    return true;
+  return edf_less(e, &cur->dl_elem, NULL);
+}
+
+/* Timer callback that ends throttled deadline thread T_'s
+   period, replenishing its budget and making it ready again. */
+static void edf_unthrottle(void* t_) {
+  struct thread* t = t_;
+
+  ASSERT(t->dl_throttled);
+
+  edf_replenish(t, timer_ticks());
+  heap_push(&edf_ready_heap, &t->dl_elem);
+  if (edf_should_preempt(thread_current()))
+    intr_yield_on_return();
+}
+
+/* Per-tick SCHED_EDF bookkeeping for the running thread CUR,
+   called from thread_tick() in an external interrupt context.
+   Charges CUR's budget, throttling it once the budget runs out. */
+static void edf_tick(struct thread* cur) {
+  if (is_deadline_thread(cur) && --cur->dl_budget <= 0)
+    cur->dl_throttled = true;
+
+  if ((is_deadline_thread(cur) && cur->dl_throttled) || edf_should_preempt(cur))
+    intr_yield_on_return();
 }
 
 /* Not an actual scheduling policy — placeholder for empty
@@ -587,6 +1296,8 @@ void thread_switch_tail(struct thread* prev) {
 
   /* Mark us as running. */
   cur->status = THREAD_RUNNING;
+  if (prev != NULL && cur != idle_thread)
+    schedstat_switch_in(cur);
 
   /* Start new time slice. */
   thread_ticks = 0;
@@ -603,7 +1314,7 @@ void thread_switch_tail(struct thread* prev) {
      palloc().) */
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) {
     ASSERT(prev != cur);
-    palloc_free_page(prev);
+    thread_page_put(prev);
   }
 }
 
@@ -623,8 +1334,14 @@ static void schedule(void) {
   ASSERT(cur->status != THREAD_RUNNING);
   ASSERT(is_thread(next));
 
-  if (cur != next)
+  if (cur != next) {
+    trace_event(TRACE_SCHEDULE, next->tid);
+    if (cur != idle_thread)
+      schedstat_switch_out(cur);
+    fpu_switch(next);
     prev = switch_threads(cur, next);
+  } else if (cur != idle_thread)
+    schedstat_resume(cur);
   thread_switch_tail(prev);
 }
 
@@ -640,6 +1357,54 @@ static tid_t allocate_tid(void) {
   return tid;
 }
 
+/* Returns a page for a new thread, recycled from an exited
+   thread if possible, or a null pointer if memory is exhausted.
+   The page's contents are arbitrary. */
+static void* thread_page_get(void) {
+  void* page = NULL;
+
+  enum intr_level old_level = intr_disable();
+  if (thread_page_cache_cnt > 0)
+    page = thread_page_cache[--thread_page_cache_cnt];
+  intr_set_level(old_level);
+
+  return page != NULL ? page : palloc_get_page(0);
+}
+
+/* Retires PAGE, which belonged to a thread that has exited, into
+   the thread page cache, or frees it if the cache is full.
+   Clears the thread's magic number, so that is_thread() rejects
+   stale pointers to it while the page sits in the cache.
+   Called with interrupts off. */
+static void thread_page_put(void* page) {
+  ASSERT(intr_get_level() == INTR_OFF);
+
+  ((struct thread*)page)->magic = 0;
+  if (thread_page_cache_cnt < THREAD_PAGE_CACHE_MAX)
+    thread_page_cache[thread_page_cache_cnt++] = page;
+  else
+    palloc_free_page(page);
+}
+
+/* Frees every page in the thread page cache and returns how
+   many were freed. */
+size_t thread_page_cache_drain(void) {
+  size_t cnt = 0;
+
+  for (;;) {
+    void* page = NULL;
+    enum intr_level old_level = intr_disable();
+    if (thread_page_cache_cnt > 0)
+      page = thread_page_cache[--thread_page_cache_cnt];
+    intr_set_level(old_level);
+
+    if (page == NULL)
+      return cnt;
+    palloc_free_page(page);
+    cnt++;
+  }
+}
+
 /* Offset of `stack' member within `struct thread'.
    Used by switch.S, which can't figure it out on its own. */
 uint32_t thread_stack_ofs = offsetof(struct thread, stack);
@@ -2,8 +2,13 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
+#include <rbtree.h>
 #include <stdint.h>
+#include "devices/timer.h"
+#include "threads/fpu.h"
+#include "threads/schedstat.h"
 #include "threads/synch.h"
 #include "threads/fixed-point.h"
 
@@ -25,6 +30,16 @@ typedef int tid_t;
 #define PRI_DEFAULT 31 /* Default priority. */
 #define PRI_MAX 63     /* Highest priority. */
 
+/* Thread niceness, used by SCHED_MLFQS. */
+#define NICE_MIN -20  /* Least nice: highest claim on the CPU. */
+#define NICE_DEFAULT 0 /* Default niceness. */
+#define NICE_MAX 20    /* Nicest: lowest claim on the CPU. */
+
+/* Thread tickets, used by SCHED_STRIDE. */
+#define TICKETS_MIN 1       /* Smallest CPU share. */
+#define TICKETS_DEFAULT 100 /* Default CPU share. */
+#define TICKETS_MAX 10000   /* Largest CPU share. */
+
 /* A kernel thread or user process.
 
    Each thread structure is stored in its own 4 kB page.  The
@@ -89,44 +104,81 @@ struct thread {
   uint8_t* stack;            /* Saved stack pointer. */
   int priority;              /* Base priority. */
   struct list_elem allelem;  /* List element for all threads list. */
-  int64_t wakeup_time;       /* While on timer_wait_list, holds wakeup time. */
 
-  /* Shared between thread.c and synch.c and timer.c. */
+  /* Shared between thread.c and synch.c. */
   struct list_elem elem; /* List element for scheduling. */
 
-  int64_t eff_priority;         // Effective priority.
-  struct list gotten_prio_list; // List of received donate_pairs from donated priorities.
-  struct lock*
-      waiting_lock; // Lock that this thread is currently waiting on. Is NULL when not waiting on lock.
+  int64_t eff_priority; // Effective priority.
+
+  /* Owned by synch.c. */
+  struct rb_elem wait_elem;   /* Element in a semaphore or condition's waiters. */
+  struct rb_tree* wait_queue; /* Waiters tree containing wait_elem, or NULL. */
+
+  /* Owned by synch.c, used for priority donation. */
+  struct lock* waiting_lock; /* Lock being waited on, or NULL. */
+  struct rb_elem donor_elem; /* Element in waiting_lock's donors tree. */
+  struct rb_tree held_locks; /* Held locks with waiters, by top donor. */
+
+  /* Owned by thread.c, used by SCHED_MLFQS. */
+  int nice;                 /* Niceness. */
+  fixed_point_t recent_cpu; /* Recent CPU usage, decayed once a second. */
+  int64_t mlfqs_epoch;      /* Second in which recent_cpu was last decayed. */
+
+  /* Owned by thread.c, used by SCHED_FAIR. */
+  struct rb_elem fair_elem; /* Element in the fair ready tree. */
+  uint64_t vruntime;        /* Weighted CPU time received. */
+
+  /* Owned by thread.c, used by SCHED_STRIDE. */
+  struct rb_elem stride_elem; /* Element in the stride ready tree. */
+  int tickets;                /* Share of the CPU. */
+  uint64_t pass;              /* Virtual time of the next quantum. */
+
+  /* Owned by thread.c, used by SCHED_EDF. */
+  struct heap_elem dl_elem; /* Element in the EDF ready heap. */
+  int64_t dl_period;        /* Period in ticks, or 0 if not a deadline thread. */
+  int64_t dl_runtime;       /* Budget per period, in ticks. */
+  int64_t dl_deadline;      /* Absolute deadline of the current period. */
+  int64_t dl_budget;        /* Budget left in the current period, in ticks. */
+  uint32_t dl_util;         /* Reserved share of the CPU, out of EDF_UTIL_SCALE. */
+  bool dl_throttled;        /* Out of budget until dl_deadline? */
+  struct timer dl_timer;    /* Ends the throttled period at dl_deadline. */
+
+  /* Owned by fpu.c. */
+  struct fpu_state fpu; /* FPU state while another thread owns the FPU. */
+  bool fpu_used;        /* Has this thread executed an FPU instruction? */
+
+  /* Owned by schedstat.c. */
+  struct sched_stats* sched_stats; /* Run-queue waits, slices, and switches, or NULL. */
+  uint64_t ready_tsc;              /* When last made ready, or 0 once its wait is counted. */
+  uint64_t run_tsc;                /* When last switched to. */
 
   struct list_elem proc_thread_list_elem; /* List element on the process's thread_list. */
   struct join_status* join_status;        // pointer to its own join status
 
-  void* saved_upage; // save ptr to user stack for freeing in pthread_exit
+  size_t stack_slot; // user stack region, see setup_thread()
   bool is_exiting; // is the process currently exiting?
 
 #ifdef USERPROG
   /* Owned by process.c. */
   struct process* pcb; /* Process control block if this thread is a userprog */
+  struct tcb* user_tcb; /* User thread control block, or NULL. */
+  void* user_esp;       /* User stack pointer at the last system call. */
+  uint8_t* stack_bottom; /* Lowest page of the user stack mapped so far. */
 #endif
 
   /* Owned by thread.c. */
   unsigned magic; /* Detects stack overflow. */
 };
 
-struct donate_pair {
-  struct lock* lock_name; // pointer to lock that caused the donation
-  int priority;           // priority of the thread waiting on lock (i.e. donator)
-  struct list_elem elem;
-};
-
 /* Types of scheduler that the user can request the kernel
  * use to schedule threads at runtime. */
 enum sched_policy {
-  SCHED_FIFO,  // First-in, first-out scheduler
-  SCHED_PRIO,  // Strict-priority scheduler with round-robin tiebreaking
-  SCHED_FAIR,  // Implementation-defined fair scheduler
-  SCHED_MLFQS, // Multi-level Feedback Queue Scheduler
+  SCHED_FIFO,   // First-in, first-out scheduler
+  SCHED_PRIO,   // Strict-priority scheduler with round-robin tiebreaking
+  SCHED_FAIR,   // Implementation-defined fair scheduler
+  SCHED_MLFQS,  // Multi-level Feedback Queue Scheduler
+  SCHED_STRIDE, // Proportional-share stride scheduler
+  SCHED_EDF,    // Earliest-deadline-first over strict priority
 };
 #define SCHED_DEFAULT SCHED_FIFO
 
@@ -147,6 +199,7 @@ tid_t thread_create(const char* name, int priority, thread_func*, void*);
 
 void thread_block(void);
 void thread_unblock(struct thread*);
+void thread_wakeup(struct thread*);
 
 struct thread* thread_current(void);
 tid_t thread_tid(void);
@@ -155,15 +208,23 @@ const char* thread_name(void);
 void thread_exit(void) NO_RETURN;
 void thread_yield(void);
 
+size_t thread_page_cache_drain(void);
+
 /* Performs some operation on thread t, given auxiliary data AUX. */
 typedef void thread_action_func(struct thread* t, void* aux);
 void thread_foreach(thread_action_func*, void*);
 
 int thread_get_priority(void);
 void thread_set_priority(int);
+void thread_set_eff_priority(struct thread*, int64_t);
+int thread_ready_max_priority(void);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
+int thread_get_tickets(void);
+void thread_set_tickets(int);
+bool thread_set_deadline(int64_t period, int64_t runtime);
+void thread_deadline_yield(void);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
 
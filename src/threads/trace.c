@@ -0,0 +1,168 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/tsc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef FILESYS
+#include "devices/block.h"
+#endif
+
+/* Binary event trace.
+
+   Hook points throughout the kernel call trace_event(), which
+   costs a test of trace_enabled when tracing is off.  When it is
+   on, trace_log() claims the next slot of a ring buffer of
+   TRACE_RECORD_CNT fixed-size records with a single XADD, which
+   cannot be split by an interrupt, and fills it in with the time
+   stamp counter, the event, and the running thread, without
+   disabling interrupts or taking locks.  Once the buffer is full
+   the oldest records are overwritten.
+
+   At shutdown, trace_dump() writes out what the buffer holds,
+   oldest first, either as lines of hex on the console or as raw
+   records on the scratch disk after a one-sector header.
+   utils/pintos-trace turns either into Chrome trace-event JSON.
+
+   Controlled by kernel command-line option "-trace". */
+
+#define TRACE_PAGES 64
+#define TRACE_RECORD_CNT (TRACE_PAGES * PGSIZE / sizeof(struct trace_record))
+
+/* Header of a trace on the scratch disk. */
+#define TRACE_MAGIC 0x43525450 /* "PTRC". */
+struct trace_header {
+  uint32_t magic;      /* TRACE_MAGIC. */
+  uint32_t record_cnt; /* Number of records that follow. */
+  uint32_t tsc_khz;    /* TSC rate, for converting to time. */
+};
+
+bool trace_enabled;
+static enum trace_mode mode;
+static struct trace_record* records;
+static uint32_t next_record; /* Total records ever claimed. */
+
+static void dump_serial(const struct trace_record*, uint32_t first, uint32_t cnt);
+static void dump_scratch(const struct trace_record*, uint32_t first, uint32_t cnt);
+
+/* Selects where trace_dump() will write the trace.  Tracing does
+   not start until trace_init(). */
+void trace_configure(enum trace_mode m) { mode = m; }
+
+/* Allocates the trace buffer and starts tracing, if
+   trace_configure() asked for a trace. */
+void trace_init(void) {
+  if (mode == TRACE_OFF)
+    return;
+
+  records = palloc_get_multiple(0, TRACE_PAGES);
+  if (records == NULL) {
+    printf("trace: out of memory for trace buffer\n");
+    return;
+  }
+  trace_enabled = true;
+}
+
+/* Returns the running thread's tid.  Like running_thread() in
+   thread.c, finds the running thread's struct thread at the start
+   of the page that holds the stack, because thread_current()
+   would object to the thread states that schedule() passes
+   through. */
+static inline tid_t current_tid(void) {
+  uint32_t esp;
+  asm("mov %%esp, %0" : "=g"(esp));
+  return ((struct thread*)pg_round_down((void*)esp))->tid;
+}
+
+/* Records EVENT with argument ARG.  Use trace_event() instead. */
+void trace_log(enum trace_event event, uint32_t arg) {
+  uint32_t idx = 1;
+  struct trace_record* r;
+
+  asm volatile("xaddl %0, %1" : "+r"(idx), "+m"(next_record));
+  r = &records[idx % TRACE_RECORD_CNT];
+  r->tsc = tsc_read();
+  r->event = event;
+  r->tid = current_tid();
+  r->arg = arg;
+}
+
+/* Stops tracing and writes out the trace. */
+void trace_dump(void) {
+  uint32_t first, cnt;
+
+  if (!trace_enabled)
+    return;
+  trace_enabled = false;
+
+  cnt = next_record < TRACE_RECORD_CNT ? next_record : TRACE_RECORD_CNT;
+  first = next_record - cnt;
+  if (mode == TRACE_SCRATCH)
+    dump_scratch(records, first, cnt);
+  else
+    dump_serial(records, first, cnt);
+}
+
+/* Prints the CNT records starting with number FIRST in R to the
+   console. */
+static void dump_serial(const struct trace_record* r, uint32_t first, uint32_t cnt) {
+  uint32_t i;
+
+  printf("Trace: %" PRIu32 " records, %" PRIu32 " kHz TSC\n", cnt, tsc_khz());
+  for (i = first; i != first + cnt; i++) {
+    const struct trace_record* rec = &r[i % TRACE_RECORD_CNT];
+    printf("T %016llx %04x %04x %08" PRIx32 "\n", rec->tsc, rec->event, rec->tid, rec->arg);
+  }
+  printf("Trace: end\n");
+}
+
+#ifdef FILESYS
+/* Writes the CNT records starting with number FIRST in R to the
+   scratch disk, after a header sector. */
+static void dump_scratch(const struct trace_record* r, uint32_t first, uint32_t cnt) {
+  enum { PER_SECTOR = BLOCK_SECTOR_SIZE / sizeof *r };
+  struct block* scratch = block_get_role(BLOCK_SCRATCH);
+  static struct trace_record buf[PER_SECTOR];
+  struct trace_header* h = (struct trace_header*)buf;
+  block_sector_t sector, sector_cnt;
+
+  if (scratch == NULL) {
+    printf("trace: no scratch disk, dumping to console\n");
+    dump_serial(r, first, cnt);
+    return;
+  }
+
+  /* Write as many of the newest records as fit. */
+  sector_cnt = DIV_ROUND_UP(cnt, PER_SECTOR);
+  if (sector_cnt > block_size(scratch) - 1) {
+    sector_cnt = block_size(scratch) - 1;
+    first += cnt - sector_cnt * PER_SECTOR;
+    cnt = sector_cnt * PER_SECTOR;
+  }
+
+  memset(buf, 0, sizeof buf);
+  h->magic = TRACE_MAGIC;
+  h->record_cnt = cnt;
+  h->tsc_khz = tsc_khz();
+  block_write(scratch, 0, buf);
+
+  for (sector = 0; sector < sector_cnt; sector++) {
+    uint32_t i;
+
+    memset(buf, 0, sizeof buf);
+    for (i = 0; i < PER_SECTOR && sector * PER_SECTOR + i < cnt; i++)
+      buf[i] = r[(first + sector * PER_SECTOR + i) % TRACE_RECORD_CNT];
+    block_write(scratch, sector + 1, buf);
+  }
+  printf("Trace: %" PRIu32 " records written to %s\n", cnt, block_name(scratch));
+}
+#else
+static void dump_scratch(const struct trace_record* r, uint32_t first, uint32_t cnt) {
+  printf("trace: no scratch disk without a file system, dumping to console\n");
+  dump_serial(r, first, cnt);
+}
+#endif
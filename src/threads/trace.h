@@ -0,0 +1,54 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Traced events.  The decoder in utils/pintos-trace knows these
+   numbers, so only ever add to the end. */
+enum trace_event {
+  TRACE_SCHEDULE,       /* Switching away from the thread; ARG is the next tid. */
+  TRACE_THREAD_BLOCK,   /* Thread blocked itself. */
+  TRACE_THREAD_UNBLOCK, /* Thread unblocked another; ARG is its tid. */
+  TRACE_INTR_ENTER,     /* Entered intr_handler(); ARG is the vector. */
+  TRACE_INTR_EXIT,      /* Leaving intr_handler(); ARG is the vector. */
+  TRACE_SYSCALL_ENTER,  /* Entered syscall_handler(); ARG is the number. */
+  TRACE_SYSCALL_EXIT,   /* Leaving syscall_handler(); ARG is the result. */
+  TRACE_BLOCK_READ,     /* Starting block_read(); ARG is the sector. */
+  TRACE_BLOCK_WRITE,    /* Starting block_write(); ARG is the sector. */
+  TRACE_BLOCK_DONE,     /* Finished block_read() or block_write(). */
+  TRACE_LOCK_CONTEND,   /* Waiting for a held lock; ARG is the holder's tid. */
+  TRACE_SOFTIRQ_ENTER,  /* Running softirqs; ARG is the pending bitmap. */
+  TRACE_SOFTIRQ_EXIT,   /* Done running softirqs; ARG is the pending bitmap. */
+  TRACE_EVENT_CNT
+};
+
+/* Where trace_dump() writes the trace. */
+enum trace_mode {
+  TRACE_OFF,    /* Not tracing. */
+  TRACE_SERIAL, /* Print records to the console. */
+  TRACE_SCRATCH /* Write records to the scratch disk. */
+};
+
+/* One trace record. */
+struct trace_record {
+  uint64_t tsc;   /* Time stamp counter. */
+  uint16_t event; /* enum trace_event. */
+  uint16_t tid;   /* Running thread. */
+  uint32_t arg;   /* Event-specific argument. */
+};
+
+extern bool trace_enabled;
+
+void trace_configure(enum trace_mode);
+void trace_init(void);
+void trace_log(enum trace_event, uint32_t arg);
+void trace_dump(void);
+
+/* Records EVENT with argument ARG, if tracing is enabled. */
+static inline void trace_event(enum trace_event event, uint32_t arg) {
+  if (trace_enabled)
+    trace_log(event, arg);
+}
+
+#endif /* threads/trace.h */
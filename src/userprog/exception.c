@@ -5,6 +5,9 @@
 #include "userprog/process.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -43,7 +46,6 @@ void exception_init(void) {
   intr_register_int(0, 0, INTR_ON, kill, "#DE Divide Error");
   intr_register_int(1, 0, INTR_ON, kill, "#DB Debug Exception");
   intr_register_int(6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-  intr_register_int(7, 0, INTR_ON, kill, "#NM Device Not Available Exception");
   intr_register_int(11, 0, INTR_ON, kill, "#NP Segment Not Present");
   intr_register_int(12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
   intr_register_int(13, 0, INTR_ON, kill, "#GP General Protection Exception");
@@ -136,9 +138,26 @@ static void page_fault(struct intr_frame* f) {
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
-  /* To implement virtual memory, delete the rest of the function
-     body, and replace it with code that brings in the page to
-     which fault_addr refers. */
+#ifdef VM
+  /* Bring in the page, if the process has one at FAULT_ADDR.
+     The kernel faults here too, when it touches a user page that
+     has not been brought in yet. */
+  if (not_present && page_fault_in(fault_addr))
+    return;
+
+  /* Give the process its own copy of a page it shares with its
+     parent or child since fork(), once one of them writes to it. */
+  if (!not_present && write && page_copy_on_write(fault_addr))
+    return;
+#endif
+
+  /* Grow the stack, if the access looks like a push.  When the
+     kernel faults on a user address, compare against the user
+     stack pointer saved on entry to the system call. */
+  if (not_present &&
+      process_grow_stack(fault_addr, user ? f->esp : thread_current()->user_esp))
+    return;
+
   printf("Page fault at %p: %s error %s page in %s context.\n", fault_addr,
          not_present ? "not present" : "rights violation", write ? "writing" : "reading",
          user ? "user" : "kernel");
@@ -0,0 +1,150 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdio.h>
+#include "threads/malloc.h"
+#include "threads/synch.h"
+
+/* Fast user-space mutexes.
+
+   User-level locks and semaphores live entirely in user memory
+   and are taken and released with atomic instructions, so the
+   kernel only hears about them when a thread has to wait.  It
+   then provides two operations on a user word, the futex:
+   futex_wait() sleeps until woken, provided the word still holds
+   the value the caller last saw, and futex_wake() wakes up to a
+   given number of sleepers.  Checking the value and going to
+   sleep happen under futex_lock, as does every wakeup, so a
+   thread that changes the word and then calls futex_wake()
+   cannot slip in between and leave a sleeper behind.
+
+   A futex is identified by its process's page directory and its
+   user address.  Only futexes with sleepers are in the table:
+   the first waiter creates the entry and the wakeup that takes
+   the last one off frees it. */
+
+/* A user word with threads sleeping on it. */
+struct futex {
+  struct hash_elem elem; /* Element in futex_table. */
+  uint32_t* pd;          /* Page directory of the owning process. */
+  const int* uaddr;      /* User address of the word. */
+  struct list waiters;   /* List of struct futex_waiter, oldest first. */
+};
+
+/* A thread sleeping in futex_wait(). */
+struct futex_waiter {
+  struct list_elem elem; /* Element in struct futex's waiters. */
+  struct semaphore sema; /* Upped by futex_wake(). */
+};
+
+static struct hash futex_table;
+static struct lock futex_lock;
+
+/* Statistics. */
+static long long futex_wait_cnt; /* # of calls to futex_wait(). */
+static long long futex_wake_cnt; /* # of calls to futex_wake(). */
+
+static hash_hash_func futex_hash;
+static hash_less_func futex_less;
+static struct futex* futex_find(uint32_t* pd, const int* uaddr);
+
+/* Initializes the futex table. */
+void futex_init(void) {
+  hash_init(&futex_table, futex_hash, futex_less, NULL);
+  lock_init(&futex_lock);
+}
+
+/* If the word at UADDR in page directory PD still holds VAL,
+   sleeps until a futex_wake() on the same word wakes this thread
+   and returns true.  Otherwise, or if memory is too short to
+   wait, returns false at once.  UADDR must be a valid, mapped,
+   aligned user address. */
+bool futex_wait(uint32_t* pd, const int* uaddr, int val) {
+  struct futex_waiter w;
+  struct futex* f;
+
+  lock_acquire(&futex_lock);
+  futex_wait_cnt++;
+  if (*(volatile const int*)uaddr != val) {
+    lock_release(&futex_lock);
+    return false;
+  }
+
+  f = futex_find(pd, uaddr);
+  if (f == NULL) {
+    f = malloc(sizeof *f);
+    if (f == NULL) {
+      lock_release(&futex_lock);
+      return false;
+    }
+    f->pd = pd;
+    f->uaddr = uaddr;
+    list_init(&f->waiters);
+    hash_insert(&futex_table, &f->elem);
+  }
+  sema_init(&w.sema, 0);
+  list_push_back(&f->waiters, &w.elem);
+  lock_release(&futex_lock);
+
+  sema_down(&w.sema);
+  return true;
+}
+
+/* Wakes up to CNT threads sleeping on the word at UADDR in page
+   directory PD, oldest first, and returns the number woken. */
+int futex_wake(uint32_t* pd, const int* uaddr, int cnt) {
+  int woken = 0;
+
+  lock_acquire(&futex_lock);
+  futex_wake_cnt++;
+  struct futex* f = futex_find(pd, uaddr);
+  if (f != NULL) {
+    while (woken < cnt && !list_empty(&f->waiters)) {
+      struct futex_waiter* w = list_entry(list_pop_front(&f->waiters), struct futex_waiter, elem);
+      sema_up(&w->sema);
+      woken++;
+    }
+    if (list_empty(&f->waiters)) {
+      hash_delete(&futex_table, &f->elem);
+      free(f);
+    }
+  }
+  lock_release(&futex_lock);
+  return woken;
+}
+
+/* Prints futex statistics.  Each call is one trap into the
+   kernel from a user lock, semaphore or other synchronization
+   primitive that had to wait or wake a waiter. */
+void futex_print_stats(void) {
+  printf("Futex: %lld waits, %lld wakes\n", futex_wait_cnt, futex_wake_cnt);
+}
+
+/* Returns the futex for UADDR in PD, or a null pointer if no
+   thread is sleeping on it. */
+static struct futex* futex_find(uint32_t* pd, const int* uaddr) {
+  struct futex key;
+  struct hash_elem* e;
+
+  key.pd = pd;
+  key.uaddr = uaddr;
+  e = hash_find(&futex_table, &key.elem);
+  return e != NULL ? hash_entry(e, struct futex, elem) : NULL;
+}
+
+/* Returns a hash value for futex E. */
+static unsigned futex_hash(const struct hash_elem* e, void* aux UNUSED) {
+  const struct futex* f = hash_entry(e, struct futex, elem);
+  return hash_int((uintptr_t)f->uaddr ^ ((uintptr_t)f->pd >> 12));
+}
+
+/* Returns true if futex A precedes futex B. */
+static bool futex_less(const struct hash_elem* a_, const struct hash_elem* b_,
+                       void* aux UNUSED) {
+  const struct futex* a = hash_entry(a_, struct futex, elem);
+  const struct futex* b = hash_entry(b_, struct futex, elem);
+  if (a->pd != b->pd)
+    return a->pd < b->pd;
+  return a->uaddr < b->uaddr;
+}
@@ -17,7 +17,9 @@
    types of segments are of interest: code, data, and TSS or
    Task-State Segment descriptors.  The former two types are
    exactly what they sound like.  The TSS is used primarily for
-   stack switching on interrupts.
+   stack switching on interrupts.  One data segment, SEL_UTLS, is
+   rebased on every context switch to the running user thread's
+   control block, to give it thread-local storage through %gs.
 
    For more information on the GDT as used here, refer to
    [IA32-v3a] 3.2 "Using Segments" through 3.5 "System Descriptor
@@ -28,6 +30,7 @@ static uint64_t gdt[SEL_CNT];
 static uint64_t make_code_desc(int dpl);
 static uint64_t make_data_desc(int dpl);
 static uint64_t make_tss_desc(void* laddr);
+static uint64_t make_tls_desc(void* base);
 static uint64_t make_gdtr_operand(uint16_t limit, void* base);
 
 /* Sets up a proper GDT.  The bootstrap loader's GDT didn't
@@ -42,6 +45,7 @@ void gdt_init(void) {
   gdt[SEL_UCSEG / sizeof *gdt] = make_code_desc(3);
   gdt[SEL_UDSEG / sizeof *gdt] = make_data_desc(3);
   gdt[SEL_TSS / sizeof *gdt] = make_tss_desc(tss_get());
+  gdt[SEL_UTLS / sizeof *gdt] = make_tls_desc(NULL);
 
   /* Load GDTR, TR.  See [IA32-v3a] 2.4.1 "Global Descriptor
      Table Register (GDTR)", 2.4.4 "Task Register (TR)", and
@@ -51,6 +55,13 @@ void gdt_init(void) {
   asm volatile("ltr %w0" : : "q"(SEL_TSS));
 }
 
+/* Moves the base of the user thread-local storage segment to
+   BASE, the running thread's control block (see lib/tcb.h).  The
+   change takes effect the next time %gs is loaded with SEL_UTLS,
+   which happens on every return to user mode, because
+   intr_exit() pops %gs from the interrupt frame. */
+void gdt_set_tls(void* base) { gdt[SEL_UTLS / sizeof *gdt] = make_tls_desc(base); }
+
 /* System segment or code/data segment? */
 enum seg_class {
   CLS_SYSTEM = 0,   /* System segment. */
@@ -120,6 +131,14 @@ static uint64_t make_tss_desc(void* laddr) {
   return make_seg_desc((uint32_t)laddr, 0x67, CLS_SYSTEM, 9, 0, GRAN_BYTE);
 }
 
+/* Returns a descriptor for a writable user data segment with
+   its base at the given linear address.  The limit is 4 GB, so
+   that negative offsets from BASE wrap around to the thread-local
+   storage just below it. */
+static uint64_t make_tls_desc(void* base) {
+  return make_seg_desc((uint32_t)base, 0xfffff, CLS_CODE_DATA, 2, 3, GRAN_PAGE);
+}
+
 /* Returns a descriptor that yields the given LIMIT and BASE when
    used as an operand for the LGDT instruction. */
 static uint64_t make_gdtr_operand(uint16_t limit, void* base) {
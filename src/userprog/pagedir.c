@@ -136,6 +136,13 @@ void pagedir_clear_page(uint32_t* pd, void* upage) {
   }
 }
 
+/* Returns true if virtual page VPAGE is mapped in PD and the
+   user process may write to it. */
+bool pagedir_is_writable(uint32_t* pd, const void* vpage) {
+  uint32_t* pte = lookup_page(pd, vpage, false);
+  return pte != NULL && (*pte & (PTE_P | PTE_W)) == (PTE_P | PTE_W);
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
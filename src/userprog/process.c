@@ -5,26 +5,50 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <syscall-nr.h>
+#include <tcb.h>
 #include "userprog/gdt.h"
 #include "userprog/pagedir.h"
 #include "userprog/tss.h"
+#include "devices/tsc.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
+#include "threads/fpu.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 
+extern struct lock file_lock;
+
 static thread_func start_process NO_RETURN;
 static thread_func start_pthread NO_RETURN;
+#ifdef VM
+static thread_func start_fork NO_RETURN;
+static bool clone_files(struct process* dst, struct process* src);
+#endif
+static void init_main_thread(proc_status_t*);
 static bool load(char* file_name, void (**eip)(void), void** esp);
+static uint8_t* stack_top(size_t slot);
+static bool add_stack_page(void* upage);
+static void init_user_stack(struct thread*, size_t slot);
+static bool map_stack_to(const void* addr);
+static void free_user_stack(struct thread*);
 bool setup_thread(void (**eip)(void), void** esp, thread_init_t* args);
 
+/* Statistics on loading executables, for process_print_stats(). */
+static uint64_t load_cnt;          /* Executables loaded. */
+static uint64_t load_cycles;       /* Time spent in successful loads. */
+static uint64_t exit_cnt;          /* Processes that exited. */
+static uint64_t image_page_sum;    /* Their executables' pages... */
+static uint64_t resident_page_sum; /* ...and how many were ever read in. */
+
 /* Initializes user programs in the system by ensuring the main
    thread has a minimal PCB so that it can execute and wait for
    the first user process. Any additions to the PCB should be also
@@ -132,16 +156,44 @@ static void start_process(void* attr_) {
     t->pcb->main_thread = t;
     strlcpy(t->pcb->process_name, t->name, sizeof t->name);
   }
+#ifdef VM
+  if (success)
+    success = pcb_success = page_table_init(&new_pcb->pages);
+  if (!success && new_pcb != NULL) {
+    t->pcb = NULL;
+    free(new_pcb);
+    new_pcb = NULL;
+  }
+#endif
+
+  /* Reserve the top stack region for the main thread. */
+  if (success) {
+    new_pcb->stack_page_cnt = 0;
+    new_pcb->stack_slots = bitmap_create(STACK_REGION_CNT);
+    success = new_pcb->stack_slots != NULL;
+    if (success)
+      bitmap_mark(new_pcb->stack_slots, 0);
+    t->stack_slot = 0;
+  }
 
   /* Initialize interrupt frame and load executable. */
   if (success) {
     memset(&if_, 0, sizeof if_);
-    if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+    if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+    if_.gs = SEL_UTLS;
     if_.cs = SEL_UCSEG;
     if_.eflags = FLAG_IF | FLAG_MBS;
+    uint64_t start = tsc_read();
     success = load(file_name, &if_.eip, &if_.esp);
+    if (success) {
+      enum intr_level old_level = intr_disable();
+      load_cnt++;
+      load_cycles += tsc_read() - start;
+      intr_set_level(old_level);
+    }
 
-    asm volatile("fninit; fsave (%0)" : : "g"(&if_.fpu));
+    /* Start the process with a fresh FPU. */
+    fpu_reset();
   }
 
   /* Handle failure with succesful PCB malloc. Must free the PCB */
@@ -151,34 +203,18 @@ static void start_process(void* attr_) {
     // can try to activate the pagedir, but it is now freed memory
     struct process* pcb_to_free = t->pcb;
     t->pcb = NULL;
+#ifdef VM
+    page_table_destroy(&pcb_to_free->pages);
+#endif
+    bitmap_destroy(pcb_to_free->stack_slots);
     free(pcb_to_free);
   }
 
   if (success) {
-    attr->status_ptr->pid = t->tid;
-    t->pcb->own_status = attr->status_ptr;
-    t->pcb->child_status_list = (struct list*)malloc(sizeof(struct list));
     t->pcb->file_desc_list = (struct list*)malloc(sizeof(struct list));
-    list_init(t->pcb->child_status_list);
     list_init(t->pcb->file_desc_list);
-    list_init(&(t->pcb->thread_list));
-    list_init(&t->pcb->join_status_list);
-    t->pcb->stack_page_cnt = 1;
     t->pcb->file_desc_count = 2;
-    cond_init(&t->pcb->exit_cond_var);
-    lock_init(&t->pcb->master_lock);
-
-    t->is_exiting = false;
-    // allocate and initialize a join_status for the main thread
-    join_status_t* main_status = malloc(sizeof(join_status_t));
-    sema_init(&main_status->join_sema, 0);
-    main_status->was_joined = false;
-    main_status->tid = t->tid;
-    t->join_status = main_status;
-    list_push_front(&t->pcb->join_status_list, &main_status->elem);
-
-    // put main thread onto thread_list
-    list_push_front(&t->pcb->thread_list, &t->proc_thread_list_elem);
+    init_main_thread(attr->status_ptr);
   }
 
   sema_up(&(attr->status_ptr->wait_sema));
@@ -198,6 +234,229 @@ static void start_process(void* attr_) {
   NOT_REACHED();
 }
 
+/* Finishes setting up the PCB of the running thread, the main
+   thread of a new process whose address space and open files are
+   ready, and reports the process's pid through STATUS. */
+static void init_main_thread(proc_status_t* status) {
+  struct thread* t = thread_current();
+
+  status->pid = t->tid;
+  t->pcb->own_status = status;
+  t->pcb->child_status_list = (struct list*)malloc(sizeof(struct list));
+  list_init(t->pcb->child_status_list);
+  list_init(&(t->pcb->thread_list));
+  list_init(&t->pcb->join_status_list);
+  cond_init(&t->pcb->exit_cond_var);
+  lock_init(&t->pcb->master_lock);
+
+  t->is_exiting = false;
+  // allocate and initialize a join_status for the main thread
+  join_status_t* main_status = malloc(sizeof(join_status_t));
+  sema_init(&main_status->join_sema, 0);
+  main_status->was_joined = false;
+  main_status->tid = t->tid;
+  t->join_status = main_status;
+  list_push_front(&t->pcb->join_status_list, &main_status->elem);
+
+  // put main thread onto thread_list
+  list_push_front(&t->pcb->thread_list, &t->proc_thread_list_elem);
+}
+
+#ifdef VM
+/* Starts a new process that is a copy of the running one, as by
+   the fork() system call whose interrupt frame is F.  The child
+   returns from the system call with 0; the parent gets the
+   child's pid, or -1 if the child could not be created.
+
+   Only the calling thread is copied.  Memory is shared
+   copy-on-write (see vm/page.c and vm/frame.c), so fork() costs
+   a page table walk rather than a copy of the address space.
+   Files mapped with mmap() are not inherited. */
+pid_t process_fork(const struct intr_frame* f) {
+  thread_init_t attr;
+  tid_t tid;
+
+  proc_status_t* status_ptr = (proc_status_t*)malloc(sizeof(proc_status_t));
+  if (status_ptr == NULL)
+    return -1;
+  status_ptr->pid = -1;
+  status_ptr->parent_pcb = thread_current()->pcb;
+  sema_init(&(status_ptr->wait_sema), 0);
+  lock_init(&(status_ptr->ref_lock));
+  status_ptr->ref_count = 2;
+
+  memset(&attr, 0, sizeof attr);
+  attr.status_ptr = status_ptr;
+  attr.fork_if = f;
+  attr.fork_thread = thread_current();
+
+  tid = thread_create(thread_current()->pcb->process_name, PRI_DEFAULT, start_fork, &attr);
+  if (tid != TID_ERROR)
+    sema_down(&status_ptr->wait_sema); // wait for child to copy us
+  if (tid == TID_ERROR || status_ptr->pid == -1) {
+    free(status_ptr);
+    return -1;
+  }
+  list_push_back(thread_current()->pcb->child_status_list, &status_ptr->elem);
+  return tid;
+}
+
+/* A thread function that copies the process of the thread that
+   called process_fork() and starts the copy running. */
+static void start_fork(void* attr_) {
+  thread_init_t* attr = (thread_init_t*)attr_;
+  struct thread* t = thread_current();
+  struct thread* parent_thread = attr->fork_thread;
+  struct process* parent = parent_thread->pcb;
+  struct intr_frame if_ = *attr->fork_if;
+  struct process* pcb;
+  bool success = false;
+
+  /* The copy is the child's half of fork().  The parent's
+     syscall_handler() traces the parent's half, and this thread
+     returns to user mode without passing through it. */
+  trace_event(TRACE_SYSCALL_ENTER, SYS_FORK);
+
+  /* Allocate the PCB zeroed, so that we can tell below how far we
+     got if something fails. */
+  pcb = calloc(sizeof(struct process), 1);
+  if (pcb == NULL || !page_table_init(&pcb->pages)) {
+    free(pcb);
+    pcb = NULL;
+    goto done;
+  }
+  pcb->main_thread = t;
+  strlcpy(pcb->process_name, parent->process_name, sizeof pcb->process_name);
+  t->pcb = pcb;
+
+  /* Keep the parent's stack regions, since we copy their pages. */
+  pcb->stack_slots = bitmap_create(STACK_REGION_CNT);
+  if (pcb->stack_slots == NULL)
+    goto done;
+  lock_acquire(&parent->master_lock);
+  for (size_t i = 0; i < STACK_REGION_CNT; i++)
+    bitmap_set(pcb->stack_slots, i, bitmap_test(parent->stack_slots, i));
+  pcb->stack_page_cnt = parent->stack_page_cnt;
+  lock_release(&parent->master_lock);
+
+  /* Open our own handle on the executable, for the pages that
+     are still to be read from it. */
+  lock_acquire(&file_lock);
+  pcb->exec_file = file_reopen(parent->exec_file);
+  if (pcb->exec_file != NULL)
+    file_deny_write(pcb->exec_file);
+  lock_release(&file_lock);
+  if (pcb->exec_file == NULL)
+    goto done;
+
+  pcb->pagedir = pagedir_create();
+  if (pcb->pagedir == NULL)
+    goto done;
+  pcb->pages.pd = pcb->pagedir;
+  if (!page_table_fork(&pcb->pages, &parent->pages, pcb->exec_file))
+    goto done;
+  pcb->tls_image = parent->tls_image;
+  pcb->tls_filesz = parent->tls_filesz;
+  pcb->tls_memsz = parent->tls_memsz;
+  pcb->tls_align = parent->tls_align;
+  pcb->image_page_cnt = parent->image_page_cnt;
+
+  /* Take over the calling thread's stack and control block.  The
+     control block holds the thread's tid, which is now ours. */
+  t->stack_slot = parent_thread->stack_slot;
+  t->stack_bottom = parent_thread->stack_bottom;
+  t->user_esp = if_.esp;
+  t->user_tcb = parent_thread->user_tcb;
+  process_activate();
+  if (!page_pin(&t->user_tcb->tid, sizeof t->user_tcb->tid, true))
+    goto done;
+  t->user_tcb->tid = t->tid;
+  page_unpin(&t->user_tcb->tid, sizeof t->user_tcb->tid);
+
+  success = clone_files(pcb, parent);
+
+done:
+  if (!success) {
+    /* Same ordering as in process_exit(): forget the page
+       directory before destroying it. */
+    t->pcb = NULL;
+    process_activate();
+    if (pcb != NULL) {
+      page_table_destroy(&pcb->pages);
+      if (pcb->pagedir != NULL)
+        pagedir_destroy(pcb->pagedir);
+      lock_acquire(&file_lock);
+      file_close(pcb->exec_file);
+      lock_release(&file_lock);
+      if (pcb->stack_slots != NULL)
+        bitmap_destroy(pcb->stack_slots);
+      free(pcb);
+    }
+    sema_up(&attr->status_ptr->wait_sema);
+    trace_event(TRACE_SYSCALL_EXIT, -1);
+    thread_exit();
+  }
+
+  /* Inherit the parent's FPU state, while the parent is still
+     waiting for us and cannot change it. */
+  fpu_fork(parent_thread);
+
+  init_main_thread(attr->status_ptr);
+  sema_up(&attr->status_ptr->wait_sema);
+
+  /* Return from fork() in the child with 0. */
+  if_.eax = 0;
+  trace_event(TRACE_SYSCALL_EXIT, if_.eax);
+  asm volatile("movl %0, %%esp; jmp intr_exit" : : "g"(&if_) : "memory");
+  NOT_REACHED();
+}
+
+/* Gives DST its own handle on each of SRC's open files, with the
+   same file descriptor and position.  Returns false, leaving DST
+   with no open files, if memory runs short. */
+static bool clone_files(struct process* dst, struct process* src) {
+  bool success = true;
+
+  dst->file_desc_list = (struct list*)malloc(sizeof(struct list));
+  if (dst->file_desc_list == NULL)
+    return false;
+  list_init(dst->file_desc_list);
+
+  /* Take file_lock first, as the SEEK system call does. */
+  lock_acquire(&file_lock);
+  lock_acquire(&src->master_lock);
+  for (struct list_elem* e = list_begin(src->file_desc_list); e != list_end(src->file_desc_list);
+       e = list_next(e)) {
+    file_desc_t* orig = list_entry(e, file_desc_t, elem);
+    file_desc_t* copy = malloc(sizeof(file_desc_t));
+    if (copy == NULL || (copy->file = file_reopen(orig->file)) == NULL) {
+      free(copy);
+      success = false;
+      break;
+    }
+    copy->fd = orig->fd;
+    file_seek(copy->file, file_tell(orig->file));
+    list_push_back(dst->file_desc_list, &copy->elem);
+  }
+  dst->file_desc_count = src->file_desc_count;
+  lock_release(&src->master_lock);
+  lock_release(&file_lock);
+
+  if (!success) {
+    lock_acquire(&file_lock);
+    while (!list_empty(dst->file_desc_list)) {
+      file_desc_t* desc = list_entry(list_pop_front(dst->file_desc_list), file_desc_t, elem);
+      file_close(desc->file);
+      free(desc);
+    }
+    lock_release(&file_lock);
+    free(dst->file_desc_list);
+    dst->file_desc_list = NULL;
+  }
+  return success;
+}
+#endif
+
 /* Waits for process with PID child_pid to die and returns its exit status.
    If it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If child_pid is invalid or if it was not a
@@ -290,6 +549,21 @@ void process_exit(int status) {
   release_proc_status(cur->pcb->own_status, false);
   printf("%s: exit(%d)\n", cur->pcb->process_name, status);
 
+  /* Account for how much of the executable was ever read in. */
+  enum intr_level old_level = intr_disable();
+  exit_cnt++;
+  image_page_sum += cur->pcb->image_page_cnt;
+#ifdef VM
+  resident_page_sum += cur->pcb->pages.resident_cnt;
+#else
+  resident_page_sum += cur->pcb->image_page_cnt;
+#endif
+  intr_set_level(old_level);
+
+#ifdef VM
+  page_table_destroy(&cur->pcb->pages);
+#endif
+
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pcb->pagedir;
@@ -312,6 +586,7 @@ void process_exit(int status) {
      can try to activate the pagedir, but it is now freed memory */
   struct process* pcb_to_free = cur->pcb;
   cur->pcb = NULL;
+  bitmap_destroy(pcb_to_free->stack_slots);
   free(pcb_to_free);
 
   thread_exit();
@@ -331,6 +606,20 @@ void process_activate(void) {
   /* Set thread's kernel stack for use in processing interrupts.
      This does nothing if this is not a user process. */
   tss_update();
+
+  /* Point %gs at the thread's control block for when it returns
+     to user mode. */
+  gdt_set_tls(t->user_tcb);
+}
+
+/* Prints statistics on loading executables: how long loads took
+   and how many pages of each executable were ever in memory. */
+void process_print_stats(void) {
+  printf("Exec: %llu loads, mean %llu cycles", load_cnt, load_cnt ? load_cycles / load_cnt : 0);
+  if (exit_cnt > 0)
+    printf(", %llu of %llu executable pages resident per exit", resident_page_sum / exit_cnt,
+           image_page_sum / exit_cnt);
+  printf("\n");
 }
 
 /* We load ELF binaries.  The following definitions are taken
@@ -387,6 +676,7 @@ struct Elf32_Phdr {
 #define PT_NOTE 4           /* Auxiliary info. */
 #define PT_SHLIB 5          /* Reserved. */
 #define PT_PHDR 6           /* Program header table. */
+#define PT_TLS 7            /* Thread-local storage template. */
 #define PT_STACK 0x6474e551 /* Stack segment. */
 
 /* Flags for p_flags.  See [ELF3] 2-3 and 2-4. */
@@ -395,10 +685,11 @@ struct Elf32_Phdr {
 #define PF_R 4 /* Readable. */
 
 static bool setup_stack(void** esp);
+static bool setup_tls(void** esp);
 static bool validate_segment(const struct Elf32_Phdr*, struct file*);
 static bool load_segment(struct file* file, off_t ofs, uint8_t* upage, uint32_t read_bytes,
                          uint32_t zero_bytes, bool writable);
-static void parse_args(char* filename, void** esp);
+static bool parse_args(char* filename, void** esp);
 
 /* Loads an ELF executable from FILE_NAME into the current thread.
    Stores the executable's entry point into *EIP
@@ -420,6 +711,9 @@ bool load(char* file_name, void (**eip)(void), void** esp) {
   t->pcb->pagedir = pagedir_create();
   if (t->pcb->pagedir == NULL)
     goto done;
+#ifdef VM
+  t->pcb->pages.pd = t->pcb->pagedir;
+#endif
   process_activate();
 
   /* Open executable file. */
@@ -430,6 +724,9 @@ bool load(char* file_name, void (**eip)(void), void** esp) {
   }
   t->pcb->exec_file = file;
   file_deny_write(file);
+  t->pcb->tls_filesz = t->pcb->tls_memsz = 0;
+  t->pcb->tls_align = 1;
+  t->pcb->image_page_cnt = 0;
 
   /* Read and verify executable header. */
   if (file_read(file, &ehdr, sizeof ehdr) != sizeof ehdr ||
@@ -463,6 +760,18 @@ bool load(char* file_name, void (**eip)(void), void** esp) {
       case PT_INTERP:
       case PT_SHLIB:
         goto done;
+      case PT_TLS:
+        /* The template's initialized part lies within a PT_LOAD
+           segment, so all we do here is remember where. */
+        if (phdr.p_filesz > phdr.p_memsz || phdr.p_memsz > MAX_TLS_SIZE ||
+            phdr.p_align > PGSIZE || !is_user_vaddr((void*)(phdr.p_vaddr + phdr.p_filesz)))
+          goto done;
+        t->pcb->tls_image = (const void*)phdr.p_vaddr;
+        t->pcb->tls_filesz = phdr.p_filesz;
+        t->pcb->tls_memsz = phdr.p_memsz;
+        if (phdr.p_align > 1)
+          t->pcb->tls_align = phdr.p_align;
+        break;
       case PT_LOAD:
         if (validate_segment(&phdr, file)) {
           bool writable = (phdr.p_flags & PF_W) != 0;
@@ -489,10 +798,10 @@ bool load(char* file_name, void (**eip)(void), void** esp) {
     }
   }
 
-  /* Set up stack. */
-  if (!setup_stack(esp))
+  /* Set up stack, with the main thread's TLS at its top. */
+  if (!setup_stack(esp) || !setup_tls(esp) || !parse_args(file_name, esp))
     goto done;
-  parse_args(file_name, esp);
+  t->user_esp = *esp;
 
   /* Start address. */
   *eip = (void (*)(void))ehdr.e_entry;
@@ -509,11 +818,21 @@ done:
 
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page(void* upage, void* kpage, bool writable);
+#endif
 
 /* Parse the filename for command line arguments,
-   then push them onto the stack appropriately. */
-void parse_args(char* filename, void** esp) {
+   then push them onto the stack appropriately.  Returns false if
+   the stack pages they need cannot be mapped. */
+static bool parse_args(char* filename, void** esp) {
+  /* Every argument takes at least two bytes of FILENAME, so this
+     bounds the strings, argv[], padding, argv, argc and return
+     address. */
+  size_t len = strlen(filename) + 1;
+  if (!map_stack_to((uint8_t*)*esp - len - (len / 2 + 5) * sizeof(char*) - 16))
+    return false;
+
   // push strings in forward order (easiest to implement)
   int argc = 0;
   char* save_ptr = NULL;
@@ -549,6 +868,7 @@ void parse_args(char* filename, void** esp) {
   *(int*)*esp = argc;
   *esp -= 4;
   *(int*)*esp = 0;
+  return true;
 }
 
 /* Checks whether PHDR describes a valid, loadable segment in
@@ -604,7 +924,9 @@ static bool validate_segment(const struct Elf32_Phdr* phdr, struct file* file) {
         - ZERO_BYTES bytes at UPAGE + READ_BYTES must be zeroed.
 
    The pages initialized by this function must be writable by the
-   user process if WRITABLE is true, read-only otherwise.
+   user process if WRITABLE is true, read-only otherwise.  With
+   VM, the pages are only recorded in the supplemental page table
+   here, and initialized when the process first touches them.
 
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
@@ -614,6 +936,26 @@ static bool load_segment(struct file* file, off_t ofs, uint8_t* upage, uint32_t
   ASSERT(pg_ofs(upage) == 0);
   ASSERT(ofs % PGSIZE == 0);
 
+  thread_current()->pcb->image_page_cnt += (read_bytes + zero_bytes) / PGSIZE;
+
+#ifdef VM
+  /* Only record where each page comes from.  page_fault_in()
+     reads it on first access. */
+  struct page_table* pt = &thread_current()->pcb->pages;
+  while (read_bytes > 0 || zero_bytes > 0) {
+    size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+    size_t page_zero_bytes = PGSIZE - page_read_bytes;
+
+    if (!page_record(pt, upage, file, ofs, page_read_bytes, writable))
+      return false;
+
+    read_bytes -= page_read_bytes;
+    zero_bytes -= page_zero_bytes;
+    ofs += page_read_bytes;
+    upage += PGSIZE;
+  }
+  return true;
+#else
   file_seek(file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) {
     /* Calculate how to fill this page.
@@ -646,23 +988,145 @@ static bool load_segment(struct file* file, off_t ofs, uint8_t* upage, uint32_t
     upage += PGSIZE;
   }
   return true;
+#endif
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
-   user virtual memory. */
+   user virtual memory.  The stack grows from there on demand, as
+   process_grow_stack() describes. */
 static bool setup_stack(void** esp) {
-  uint8_t* kpage;
-  bool success = false;
+  init_user_stack(thread_current(), 0);
+  if (!add_stack_page(stack_top(0) - PGSIZE))
+    return false;
+  *esp = PHYS_BASE;
+  return true;
+}
 
-  kpage = palloc_get_page(PAL_USER | PAL_ZERO);
-  if (kpage != NULL) {
-    success = install_page(((uint8_t*)PHYS_BASE) - PGSIZE, kpage, true);
-    if (success)
-      *esp = PHYS_BASE;
-    else
-      palloc_free_page(kpage);
+/* Gives thread T stack region SLOT, with no pages mapped yet.
+   Until T first enters the kernel from user mode, its user stack
+   pointer is taken to be the top of the region, so the stack
+   only grows where the kernel maps it explicitly. */
+static void init_user_stack(struct thread* t, size_t slot) {
+  t->stack_slot = slot;
+  t->stack_bottom = stack_top(slot);
+  t->user_esp = stack_top(slot);
+}
+
+/* Maps a zeroed page at UPAGE in the running thread's stack.
+   Returns false if UPAGE is already in use or memory is short. */
+static bool add_stack_page(void* upage) {
+  struct thread* t = thread_current();
+  struct process* pcb = t->pcb;
+
+#ifdef VM
+  if (!page_record(&pcb->pages, upage, NULL, 0, 0, true))
+    return false;
+  if (!page_fault_in(upage)) {
+    page_remove(&pcb->pages, upage);
+    return false;
   }
-  return success;
+#else
+  uint8_t* kpage = palloc_get_page(PAL_USER | PAL_ZERO);
+  if (kpage == NULL)
+    return false;
+  if (!install_page(upage, kpage, true)) {
+    palloc_free_page(kpage);
+    return false;
+  }
+#endif
+
+  if ((uint8_t*)upage < t->stack_bottom)
+    t->stack_bottom = upage;
+
+  enum intr_level old_level = intr_disable();
+  pcb->stack_page_cnt++;
+  intr_set_level(old_level);
+  return true;
+}
+
+/* Maps every page of the running thread's stack from the lowest
+   one mapped so far down to the one containing ADDR, so that the
+   kernel can write there before the thread runs.  The pages above
+   must all be mapped already.  Returns false if ADDR is outside
+   the thread's stack region or memory is short. */
+static bool map_stack_to(const void* addr) {
+  struct thread* t = thread_current();
+  uint8_t* upage = pg_round_down(addr);
+
+  if (upage < stack_top(t->stack_slot) - STACK_REGION_SIZE)
+    return false;
+  while (t->stack_bottom > upage)
+    if (!add_stack_page(t->stack_bottom - PGSIZE))
+      return false;
+  return true;
+}
+
+/* Returns the top of user stack region SLOT. */
+static uint8_t* stack_top(size_t slot) {
+  ASSERT(slot < STACK_REGION_CNT);
+  return (uint8_t*)PHYS_BASE - slot * STACK_REGION_SIZE;
+}
+
+/* Grows the running thread's user stack to cover FAULT_ADDR, if
+   FAULT_ADDR lies within the thread's stack region and no more
+   than 32 bytes below ESP, its user stack pointer.  PUSHA, and
+   ENTER with a small nesting level, touch memory that far below
+   the stack pointer before they move it; nothing else should
+   touch memory below it at all.  Returns true if the stack
+   grew. */
+bool process_grow_stack(void* fault_addr, void* esp) {
+  struct thread* t = thread_current();
+  uint8_t* addr = fault_addr;
+  uint8_t* top;
+
+  if (t->pcb == NULL || t->pcb->pagedir == NULL || !is_user_vaddr(addr))
+    return false;
+  top = stack_top(t->stack_slot);
+  if (addr >= top || addr < top - STACK_REGION_SIZE || addr + 32 < (uint8_t*)esp)
+    return false;
+  return add_stack_page(pg_round_down(addr));
+}
+
+/* Lays out the running thread's thread-local storage and thread
+   control block at *ESP, the top of its new user stack, and
+   moves *ESP below them, keeping it 16-byte aligned.  The
+   control block goes at the thread pointer and the TLS block
+   just below it, as lib/tcb.h describes; the TLS block starts
+   out as a copy of the executable's template, with .tbss zeroed.
+   Maps any further stack pages the blocks need.  Returns false if
+   the template is not mapped or memory is short. */
+static bool setup_tls(void** esp) {
+  struct thread* t = thread_current();
+  struct process* pcb = t->pcb;
+  const uint8_t* image = pcb->tls_image;
+  size_t tls_size = ROUND_UP(pcb->tls_memsz, pcb->tls_align);
+  uintptr_t tp = ROUND_DOWN((uintptr_t)*esp - sizeof(struct tcb), pcb->tls_align);
+  uint8_t* block = (uint8_t*)tp - tls_size;
+  struct tcb* tcb = (struct tcb*)tp;
+
+  /* The template was loaded with the executable's other
+     segments, but make sure it was mapped at all before the
+     kernel reads it. */
+  for (const uint8_t* upage = pg_round_down(image); upage < image + pcb->tls_filesz;
+       upage += PGSIZE)
+#ifdef VM
+    if (!page_fault_in(upage))
+#else
+    if (pagedir_get_page(pcb->pagedir, upage) == NULL)
+#endif
+      return false;
+  if (!map_stack_to(block))
+    return false;
+
+  memcpy(block, image, pcb->tls_filesz);
+  memset(block + pcb->tls_filesz, 0, tls_size - pcb->tls_filesz);
+  tcb->self = tcb;
+  tcb->tid = t->tid;
+
+  t->user_tcb = tcb;
+  gdt_set_tls(tcb);
+  *esp = (void*)ROUND_DOWN((uintptr_t)block, 16);
+  return true;
 }
 
 /* Adds a mapping from user virtual address UPAGE to kernel
@@ -674,6 +1138,7 @@ static bool setup_stack(void** esp) {
    with palloc_get_page().
    Returns true on success, false if UPAGE is already mapped or
    if memory allocation fails. */
+#ifndef VM
 static bool install_page(void* upage, void* kpage, bool writable) {
   struct thread* t = thread_current();
 
@@ -682,6 +1147,7 @@ static bool install_page(void* upage, void* kpage, bool writable) {
   return (pagedir_get_page(t->pcb->pagedir, upage) == NULL &&
           pagedir_set_page(t->pcb->pagedir, upage, kpage, writable));
 }
+#endif
 
 /* Returns true if t is the main thread of the process p */
 bool is_main_thread(struct thread* t, struct process* p) { return p->main_thread == t; }
@@ -716,47 +1182,80 @@ bool setup_thread(void (**eip)(void), void** esp, thread_init_t* args) {
   // set eip
   *eip = (void*)(args->sf);
 
-  // allocate thread stack and set esp
-  uint8_t* kpage = palloc_get_page(PAL_USER | PAL_ZERO);
-  bool success = false;
+  // claim a stack region and map the top page of it
+  struct process* pcb = t->pcb;
+  lock_acquire(&pcb->master_lock);
+  size_t slot = bitmap_scan_and_flip(pcb->stack_slots, 0, 1, false);
+  lock_release(&pcb->master_lock);
+  if (slot == BITMAP_ERROR)
+    return false;
+  init_user_stack(t, slot);
 
-  if (kpage != NULL) {
-    void* addr = PHYS_BASE - PGSIZE;
-    while (pagedir_get_page(t->pcb->pagedir, (uint32_t*)addr)) {
-      if (addr == 0) {
-        palloc_free_page(kpage);
-        return false;
-      }
-      addr -= PGSIZE;
-    }
+  void* addr = stack_top(slot) - PGSIZE;
+  if (!add_stack_page(addr)) {
+    lock_acquire(&pcb->master_lock);
+    bitmap_reset(pcb->stack_slots, slot);
+    lock_release(&pcb->master_lock);
+    return false;
+  }
 
-    success = install_page(addr, kpage, true);
-    if (success) {
-      *esp = addr + PGSIZE;
-      // t->pcb->stack_page_cnt++;
-      t->saved_upage = addr;
-
-      /* push args
-      0x...8 [8] padding
-      0x...4 [4] (void*) arg
-      0x...0 [4] (pthread_fun)
-      0x...c [4] fake rip */
-      *esp -= 8;
-      *((long*)*esp) = 0;
-
-      *esp -= sizeof(void*);
-      *((int**)*esp) = args->arg;
-
-      *esp -= sizeof(pthread_fun);
-      *((pthread_fun*)*esp) = args->tf;
-
-      *esp -= sizeof(int);
-      *((int*)*esp) = 0;
-    } else
+  *esp = addr + PGSIZE;
+  if (!setup_tls(esp)) {
+    free_user_stack(t);
+    return false;
+  }
+
+  /* push args
+  0x...8 [8] padding
+  0x...4 [4] (void*) arg
+  0x...0 [4] (pthread_fun)
+  0x...c [4] fake rip */
+  *esp -= 8;
+  *((long*)*esp) = 0;
+
+  *esp -= sizeof(void*);
+  *((int**)*esp) = args->arg;
+
+  *esp -= sizeof(pthread_fun);
+  *((pthread_fun*)*esp) = args->tf;
+
+  *esp -= sizeof(int);
+  *((int*)*esp) = 0;
+
+  t->user_esp = *esp;
+  return true;
+}
+
+/* Frees the stack region of thread T, which setup_thread()
+   claimed, and every page the stack grew into.  Only the part of
+   the region at or above T's lowest stack page is walked. */
+static void free_user_stack(struct thread* t) {
+  struct process* pcb = t->pcb;
+  uint8_t* top = stack_top(t->stack_slot);
+  uint8_t* upage;
+  int freed = 0;
+
+  for (upage = t->stack_bottom; upage < top; upage += PGSIZE) {
+#ifdef VM
+    if (page_remove(&pcb->pages, upage))
+      freed++;
+#else
+    void* kpage = pagedir_get_page(pcb->pagedir, upage);
+    if (kpage != NULL) {
+      pagedir_clear_page(pcb->pagedir, upage);
       palloc_free_page(kpage);
+      freed++;
+    }
+#endif
   }
 
-  return success;
+  enum intr_level old_level = intr_disable();
+  pcb->stack_page_cnt -= freed;
+  intr_set_level(old_level);
+
+  lock_acquire(&pcb->master_lock);
+  bitmap_reset(pcb->stack_slots, t->stack_slot);
+  lock_release(&pcb->master_lock);
 }
 
 /* Starts a new thread with a new user stack running SF, which takes
@@ -813,10 +1312,11 @@ static void start_pthread(void* args_) {
   // initialize interrupt frame
   struct intr_frame if_;
   memset(&if_, 0, sizeof if_);
-  if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+  if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+  if_.gs = SEL_UTLS;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  asm volatile("fninit; fsave (%0)" : : "g"(&if_.fpu));
+  fpu_reset();
 
   bool success = setup_thread(&if_.eip, &if_.esp, args);
 
@@ -892,9 +1392,7 @@ void pthread_exit(void) {
   join_status_t* status = t->join_status;
 
   // free user stack
-  void* kpage = pagedir_get_page(t->pcb->pagedir, t->saved_upage);
-  palloc_free_page(kpage);
-  pagedir_clear_page(t->pcb->pagedir, t->saved_upage); // clear page table entry
+  free_user_stack(t);
 
   lock_acquire(&t->pcb->master_lock);
   list_remove(&t->proc_thread_list_elem);
@@ -2,15 +2,32 @@
 #define USERPROG_PROCESS_H
 
 #include <stdint.h>
+#include <bitmap.h>
 #include <list.h>
+#include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "filesys/file.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 // At most 8MB can be allocated to the stack
 // These defines will be used in Project 2: Multithreading
 #define MAX_STACK_PAGES (1 << 11)
 #define MAX_THREADS 127
 
+/* Each user thread's stack grows down within its own region of
+   MAX_STACK_PAGES pages.  Region 0, at the top of user memory,
+   belongs to the main thread; the regions below it are handed
+   out to threads as they are created. */
+#define STACK_REGION_SIZE (MAX_STACK_PAGES * PGSIZE)
+#define STACK_REGION_CNT (MAX_THREADS + 1)
+
+/* At most this many bytes at the top of each user thread's stack
+   hold its thread-local storage and thread control block. */
+#define MAX_TLS_SIZE 1024
+
 /* PIDs and TIDs are the same type. PID should be
    the TID of the main thread of the process */
 typedef tid_t pid_t;
@@ -51,8 +68,21 @@ struct process {
   uint32_t file_desc_count;    /* Starts at 2, and increases when files are opened. */
   struct file* exec_file;      /* File pointer to currently executing file. */
 
+  /* Thread-local storage template, from the executable's PT_TLS
+     segment.  Each thread's TLS block starts as a copy of it. */
+  const void* tls_image; /* Initialized part (.tdata), in user memory. */
+  size_t tls_filesz;     /* Size of .tdata. */
+  size_t tls_memsz;      /* Size of .tdata and .tbss together. */
+  size_t tls_align;      /* Required alignment of the TLS block. */
+
+  size_t image_page_cnt; /* Pages in the executable's loadable segments. */
+#ifdef VM
+  struct page_table pages; /* Supplemental page table. */
+#endif
+
   struct list thread_list;
-  int stack_page_cnt;
+  int stack_page_cnt;         /* Stack pages of all threads together. */
+  struct bitmap* stack_slots; /* Stack regions in use, under master_lock. */
   struct lock
       master_lock; /* Lock used for thread_list, file_desc_list, user locks and semaphores list */
   struct list
@@ -79,14 +109,23 @@ typedef struct thread_init {
   void* arg;                  // args passed by user for starting thread
   struct process* pcb;        // pointer to pcb
   join_status_t* join_status; // pointer to join status of starting thread
+
+  // used by process_fork
+  const struct intr_frame* fork_if; // parent's interrupt frame at the fork() system call
+  struct thread* fork_thread;       // parent thread that called fork()
 } thread_init_t;
 
 void userprog_init(void);
 
 pid_t process_execute(const char* file_name);
+#ifdef VM
+pid_t process_fork(const struct intr_frame*);
+#endif
 int process_wait(pid_t);
 void process_exit(int status);
 void process_activate(void);
+void process_print_stats(void);
+bool process_grow_stack(void* fault_addr, void* esp);
 
 bool is_main_thread(struct thread*, struct process*);
 pid_t get_pid(struct process*);
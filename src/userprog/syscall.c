@@ -1,9 +1,13 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
 #include <console.h>
+#include "threads/fpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "userprog/futex.h"
 #include "userprog/process.h"
 #include "threads/vaddr.h"
 #include "pagedir.h"
@@ -15,18 +19,36 @@
 #include "filesys/filesys.h"
 #include "filesys/file.h"
 #include "lib/float.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 extern struct lock file_lock;
 extern void putbuf(const char* buffer, size_t n);
 
 static void syscall_handler(struct intr_frame*);
+static void syscall_dispatch(struct intr_frame*);
 bool validate_single(void* addr);
 bool validate_args(void* addr, size_t size);
 bool validate_str(char* ptr);
 void validate_fail(struct intr_frame*);
+static bool pin_buffer(const void* buffer, size_t size, bool write);
+static void unpin_buffer(const void* buffer, size_t size);
 void syscall_init(void) { intr_register_int(0x30, 3, INTR_ON, syscall_handler, "syscall"); }
 file_desc_t* find_file(struct process* pcb, int fd);
 
-static void syscall_handler(struct intr_frame* f UNUSED) {
+static void syscall_handler(struct intr_frame* f) {
+  thread_current()->user_esp = f->esp;
+  if (trace_enabled) {
+    uint32_t nr = UINT32_MAX;
+    if (validate_args(f->esp, sizeof(uint32_t)))
+      nr = *(uint32_t*)f->esp;
+    trace_log(TRACE_SYSCALL_ENTER, nr);
+  }
+  syscall_dispatch(f);
+  trace_event(TRACE_SYSCALL_EXIT, f->eax);
+}
+
+static void syscall_dispatch(struct intr_frame* f) {
   uint32_t* args = ((uint32_t*)f->esp);
 
   /*
@@ -76,10 +98,15 @@ static void syscall_handler(struct intr_frame* f UNUSED) {
     if (!validate_str((char*)args[1])) {
       validate_fail(f);
     }
+    size_t name_size = strlen((char*)args[1]) + 1;
+    if (!pin_buffer((char*)args[1], name_size, false)) {
+      validate_fail(f);
+    }
 
     lock_acquire(&file_lock);
     f->eax = filesys_create((char*)args[1], (unsigned int)args[2]);
     lock_release(&file_lock);
+    unpin_buffer((char*)args[1], name_size);
 
   } else if (args[0] == SYS_OPEN) {
     if (!validate_args(&args[1], sizeof(char*))) {
@@ -90,10 +117,15 @@ static void syscall_handler(struct intr_frame* f UNUSED) {
     }
     f->eax = -1;
     struct process* pcb = thread_current()->pcb;
+    size_t name_size = strlen((char*)args[1]) + 1;
+    if (!pin_buffer((char*)args[1], name_size, false)) {
+      validate_fail(f);
+    }
 
     lock_acquire(&file_lock);
     struct file* file_ptr = filesys_open((char*)args[1]);
     lock_release(&file_lock);
+    unpin_buffer((char*)args[1], name_size);
 
     if (file_ptr) {
       file_desc_t* fdesc = (file_desc_t*)malloc(sizeof(file_desc_t));
@@ -112,10 +144,15 @@ static void syscall_handler(struct intr_frame* f UNUSED) {
     if (!validate_str((char*)args[1])) {
       validate_fail(f);
     }
+    size_t name_size = strlen((char*)args[1]) + 1;
+    if (!pin_buffer((char*)args[1], name_size, false)) {
+      validate_fail(f);
+    }
 
     lock_acquire(&file_lock);
     f->eax = filesys_remove((char*)args[1]);
     lock_release(&file_lock);
+    unpin_buffer((char*)args[1], name_size);
 
   } else if (args[0] == SYS_CLOSE) {
     if (!validate_args(&args[1], sizeof(int))) {
@@ -171,9 +208,13 @@ static void syscall_handler(struct intr_frame* f UNUSED) {
       f->eax = -1;
       return;
     }
+    if (!pin_buffer((void*)args[2], (size_t)args[3], true)) {
+      validate_fail(f);
+    }
     lock_acquire(&file_lock);
     f->eax = file_read(filedesc->file, (void*)args[2], (off_t)args[3]);
     lock_release(&file_lock);
+    unpin_buffer((void*)args[2], (size_t)args[3]);
 
   } else if (args[0] == SYS_WRITE) {
     if (!validate_args(&args[1], sizeof(int) + sizeof(void*) + sizeof(unsigned int))) {
@@ -194,9 +235,13 @@ static void syscall_handler(struct intr_frame* f UNUSED) {
       f->eax = 0;
       return;
     }
+    if (!pin_buffer((void*)args[2], (size_t)args[3], false)) {
+      validate_fail(f);
+    }
     lock_acquire(&file_lock);
     f->eax = file_write(filedesc->file, (void*)args[2], (off_t)args[3]);
     lock_release(&file_lock);
+    unpin_buffer((void*)args[2], (size_t)args[3]);
 
   } else if (args[0] == SYS_SEEK) {
     if (!validate_args(&args[1], sizeof(int) + sizeof(int))) {
@@ -232,7 +277,10 @@ static void syscall_handler(struct intr_frame* f UNUSED) {
     if (!validate_args(&args[1], sizeof(int))) {
       validate_fail(f);
     }
+    struct fpu_state fpu;
+    fpu_kernel_begin(&fpu);
     f->eax = sys_sum_to_e(args[1]);
+    fpu_kernel_end(&fpu);
 
   } else if (args[0] == SYS_PT_CREATE) {
     if (!validate_args(&args[1], 3 * sizeof(void*))) {
@@ -253,9 +301,76 @@ static void syscall_handler(struct intr_frame* f UNUSED) {
     } else {
       pthread_exit();
     }
+  } else if (args[0] == SYS_FUTEX_WAIT || args[0] == SYS_FUTEX_WAKE) {
+    if (!validate_args(&args[1], 2 * sizeof(int))) {
+      validate_fail(f);
+    }
+    const int* uaddr = (const int*)args[1];
+    if ((uintptr_t)uaddr % sizeof(int) != 0 || !validate_args((void*)uaddr, sizeof(int))) {
+      validate_fail(f);
+    }
+    uint32_t* pd = thread_current()->pcb->pagedir;
+    if (args[0] == SYS_FUTEX_WAIT)
+      f->eax = futex_wait(pd, uaddr, (int)args[2]) ? 0 : -1;
+    else
+      f->eax = futex_wake(pd, uaddr, (int)args[2]);
+
   } else if (args[0] == SYS_GET_TID) {
     struct thread* t = thread_current();
     f->eax = t->tid;
+
+  } else if (args[0] == SYS_SET_DEADLINE) {
+    if (!validate_args(&args[1], 2 * sizeof(int))) {
+      validate_fail(f);
+    }
+    f->eax = thread_set_deadline((int)args[1], (int)args[2]);
+
+  } else if (args[0] == SYS_DL_YIELD) {
+    thread_deadline_yield();
+
+  } else if (args[0] == SYS_MMAP) {
+    if (!validate_args(&args[1], sizeof(int) + sizeof(void*))) {
+      validate_fail(f);
+    }
+    f->eax = -1;
+#ifdef VM
+    struct process* pcb = thread_current()->pcb;
+    file_desc_t* filedesc = find_file(pcb, args[1]);
+    if (filedesc == NULL) {
+      return;
+    }
+
+    /* The mapping keeps its own handle on the file, so that it
+       outlives the file descriptor. */
+    lock_acquire(&file_lock);
+    struct file* file = file_reopen(filedesc->file);
+    lock_release(&file_lock);
+    if (file == NULL) {
+      return;
+    }
+
+    f->eax = page_map(&pcb->pages, file, (void*)args[2]);
+    if ((int)f->eax == -1) {
+      lock_acquire(&file_lock);
+      file_close(file);
+      lock_release(&file_lock);
+    }
+#endif
+
+  } else if (args[0] == SYS_MUNMAP) {
+    if (!validate_args(&args[1], sizeof(int))) {
+      validate_fail(f);
+    }
+#ifdef VM
+    page_unmap(&thread_current()->pcb->pages, (int)args[1]);
+#endif
+
+  } else if (args[0] == SYS_FORK) {
+#ifdef VM
+    f->eax = process_fork(f);
+#else
+    f->eax = -1;
+#endif
   }
 }
 
@@ -265,7 +380,17 @@ bool validate_single(void* addr) {
   /* translate addr into page table entry */
   uint32_t* current_pd = active_pd();
   void* pg = pagedir_get_page(current_pd, addr);
-  return pg != NULL;
+  if (pg != NULL)
+    return true;
+#ifdef VM
+  /* Bring in pages that the process has not touched yet now,
+     rather than faulting on them with file_lock held. */
+  if (page_fault_in(addr))
+    return true;
+#endif
+  /* A buffer on the stack may extend into pages the stack has
+     not grown into yet. */
+  return process_grow_stack(addr, thread_current()->user_esp);
 }
 
 bool validate_args(void* addr, size_t size) {
@@ -288,6 +413,28 @@ bool validate_str(char* ptr) {
   }
 }
 
+/* Keeps the SIZE bytes of user memory at BUFFER in memory until
+   unpin_buffer() is called.  The kernel must not fault on user
+   memory while it holds file_lock, because bringing a page back
+   in may need file_lock too.  If WRITE is true, the kernel is
+   going to write to BUFFER, so a copy-on-write page must be
+   copied now rather than on the fault.  Without VM, user pages
+   stay put and there is nothing to do. */
+static bool pin_buffer(const void* buffer UNUSED, size_t size UNUSED, bool write UNUSED) {
+#ifdef VM
+  return page_pin(buffer, size, write);
+#else
+  return true;
+#endif
+}
+
+/* Undoes pin_buffer(). */
+static void unpin_buffer(const void* buffer UNUSED, size_t size UNUSED) {
+#ifdef VM
+  page_unpin(buffer, size);
+#endif
+}
+
 void validate_fail(struct intr_frame* f) {
   f->eax = -1;
   process_exit(-1);
@@ -0,0 +1,299 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/* Frame table.
+
+   Every frame from the user pool that holds a page is in the
+   frame table.  When the user pool runs out, frame_alloc()
+   evicts a page with the "clock" second-chance algorithm: the
+   clock hand sweeps the table, clearing the accessed bit of each
+   page it passes, and stops at the first page whose accessed bit
+   was already clear, that is, one that has not been used since
+   the hand last came by.
+
+   fork() does not copy the parent's pages.  The child's copy of
+   each page in memory shares the parent's frame instead, and
+   both are mapped read-only.  The frame counts the pages that
+   share it, and the first process to write to the page takes the
+   write-protect fault and gets a copy of its own from
+   frame_unshare().  Pages that are only ever read stay shared
+   until they are evicted.
+
+   frame_lock protects the frame table and the frames in it, and
+   also the frame, swap_slot and pin_cnt members of every page.
+   It is held across the whole of an eviction, swap I/O included,
+   so a thread that faults on a page while it is being evicted
+   waits for the eviction to finish before it reads the page back
+   in.  Reading a page in happens without the lock, into a frame
+   that is pinned until the page is mapped. */
+
+static struct list frames;     /* All frames holding a page. */
+static struct list_elem* hand; /* Clock hand, or list_end() to start over. */
+static struct lock frame_lock; /* Protects the frame table. */
+
+static struct frame* frame_get(void);
+static struct frame* frame_evict(void);
+static void frame_attach(struct frame*, struct page*);
+static void frame_detach(struct frame*, struct page*);
+static void frame_free(struct frame*);
+
+/* Initializes the frame table. */
+void frame_init(void) {
+  list_init(&frames);
+  hand = list_end(&frames);
+  lock_init(&frame_lock);
+}
+
+/* Obtains a frame for page P, evicting another page if no free
+   frame is left, and returns it with P pinned in it.  The caller
+   fills in and maps the page and then calls frame_unpin().
+   Returns a null pointer if no frame is free and none can be
+   evicted. */
+struct frame* frame_alloc(struct page* p) {
+  struct frame* f;
+
+  lock_acquire(&frame_lock);
+  f = frame_get();
+  if (f != NULL) {
+    frame_attach(f, p);
+    p->pin_cnt = 1;
+    f->pin_cnt = 1;
+  }
+  lock_release(&frame_lock);
+  return f;
+}
+
+/* Pins page P in its frame, if P is in memory, and returns true.
+   Returns false if P is not in memory. */
+bool frame_pin(struct page* p) {
+  bool resident;
+
+  lock_acquire(&frame_lock);
+  resident = p->frame != NULL;
+  if (resident) {
+    p->pin_cnt++;
+    p->frame->pin_cnt++;
+  }
+  lock_release(&frame_lock);
+  return resident;
+}
+
+/* Undoes one frame_alloc() or frame_pin() of page P. */
+void frame_unpin(struct page* p) {
+  lock_acquire(&frame_lock);
+  ASSERT(p->frame != NULL && p->pin_cnt > 0);
+  p->pin_cnt--;
+  p->frame->pin_cnt--;
+  lock_release(&frame_lock);
+}
+
+/* Unmaps page P and drops its claim on the frame and swap slot
+   that hold it, if any, freeing them if no other page shares
+   them. */
+void frame_discard(struct page* p) {
+  lock_acquire(&frame_lock);
+  if (p->frame != NULL) {
+    struct frame* f = p->frame;
+
+    ASSERT(p->pin_cnt == 0);
+    pagedir_clear_page(p->pd, p->upage);
+    frame_detach(f, p);
+    if (f->ref_cnt == 0)
+      frame_free(f);
+  }
+  if (p->swap_slot != SWAP_NONE) {
+    swap_free(p->swap_slot);
+    p->swap_slot = SWAP_NONE;
+  }
+  lock_release(&frame_lock);
+}
+
+/* Makes writable page P, which the running process is about to
+   write, the only page in its frame, copying it into a new frame
+   if other processes share its current one, and maps it
+   writable.  Does nothing if P is not in memory or is mapped
+   writable already.  Returns false if P needs a new frame and
+   none can be found. */
+bool frame_unshare(struct page* p) {
+  struct frame* f;
+  bool success = true;
+
+  ASSERT(p->writable);
+
+  lock_acquire(&frame_lock);
+  f = p->frame;
+  if (f != NULL && f->ref_cnt > 1) {
+    struct frame* copy;
+
+    /* Keep F in place while we look for a frame to copy it to. */
+    f->pin_cnt++;
+    copy = frame_get();
+    f->pin_cnt--;
+    if (copy != NULL) {
+      memcpy(copy->kpage, f->kpage, PGSIZE);
+      pagedir_clear_page(p->pd, p->upage);
+      frame_detach(f, p);
+      frame_attach(copy, p);
+      pagedir_set_page(p->pd, p->upage, copy->kpage, true);
+    } else
+      success = false;
+  } else if (f != NULL && !pagedir_is_writable(p->pd, p->upage)) {
+    /* The other processes are gone.  Keep the dirty bit, which
+       remapping the page clears. */
+    if (pagedir_is_dirty(p->pd, p->upage))
+      p->dirty = true;
+    pagedir_clear_page(p->pd, p->upage);
+    pagedir_set_page(p->pd, p->upage, f->kpage, true);
+  }
+  lock_release(&frame_lock);
+  return success;
+}
+
+/* Sets up CHILD, a child process's copy of page PARENT, to hold
+   the same contents.  If PARENT is in memory, CHILD shares its
+   frame and both are mapped read-only, except that a pinned
+   writable page is copied at once, since the kernel may be about
+   to write to it.  If PARENT is in swap, CHILD shares its swap slot.
+   Otherwise CHILD will be read in from its file like PARENT.
+   Returns false if memory is short. */
+bool frame_fork(struct page* parent, struct page* child) {
+  struct frame* f;
+  bool success = true;
+
+  lock_acquire(&frame_lock);
+  f = parent->frame;
+  if (parent->writable && (f != NULL || parent->swap_slot != SWAP_NONE)) {
+    /* Fold the dirty bit into the page, since neither copy's
+       page table entry will see the writes that made it. */
+    if (f != NULL && pagedir_is_dirty(parent->pd, parent->upage))
+      parent->dirty = true;
+    child->dirty = parent->dirty;
+  }
+
+  if (f == NULL) {
+    if (parent->swap_slot != SWAP_NONE)
+      child->swap_slot = swap_dup(parent->swap_slot);
+  } else if (parent->pin_cnt > 0 && parent->writable) {
+    struct frame* copy = frame_get();
+    if (copy != NULL) {
+      memcpy(copy->kpage, f->kpage, PGSIZE);
+      if (pagedir_set_page(child->pd, child->upage, copy->kpage, child->writable))
+        frame_attach(copy, child);
+      else {
+        frame_free(copy);
+        success = false;
+      }
+    } else
+      success = false;
+  } else if (pagedir_set_page(child->pd, child->upage, f->kpage, false)) {
+    frame_attach(f, child);
+    if (parent->writable) {
+      pagedir_clear_page(parent->pd, parent->upage);
+      pagedir_set_page(parent->pd, parent->upage, f->kpage, false);
+    }
+  } else
+    success = false;
+  lock_release(&frame_lock);
+  return success;
+}
+
+/* Returns a frame with no pages in it, taken from the user pool
+   or else by evicting the pages in another frame, or a null
+   pointer if there is none to be had.  frame_lock must be
+   held. */
+static struct frame* frame_get(void) {
+  void* kpage = palloc_get_page(PAL_USER);
+  struct frame* f;
+
+  if (kpage == NULL)
+    return frame_evict();
+
+  f = malloc(sizeof *f);
+  if (f == NULL) {
+    palloc_free_page(kpage);
+    return NULL;
+  }
+  f->kpage = kpage;
+  list_init(&f->pages);
+  f->ref_cnt = 0;
+  f->pin_cnt = 0;
+  list_push_back(&frames, &f->elem);
+  return f;
+}
+
+/* Chooses a frame to evict with the clock algorithm, evicts the
+   pages in it, and returns it, empty and still in the frame
+   table.  Returns a null pointer if every frame is pinned or
+   cannot be evicted.  frame_lock must be held. */
+static struct frame* frame_evict(void) {
+  /* Two sweeps are enough: the first at worst clears every
+     accessed bit.  list_size() walks the whole list, so count
+     once. */
+  size_t sweep_cnt = 2 * list_size(&frames);
+  size_t i;
+
+  for (i = 0; i < sweep_cnt; i++) {
+    struct frame* f;
+    struct list_elem* e;
+    bool accessed = false;
+
+    if (hand == list_end(&frames))
+      hand = list_begin(&frames);
+    f = list_entry(hand, struct frame, elem);
+    hand = list_next(hand);
+
+    if (f->pin_cnt > 0)
+      continue;
+    for (e = list_begin(&f->pages); e != list_end(&f->pages); e = list_next(e)) {
+      struct page* p = list_entry(e, struct page, frame_elem);
+      if (pagedir_is_accessed(p->pd, p->upage)) {
+        pagedir_set_accessed(p->pd, p->upage, false);
+        accessed = true;
+      }
+    }
+    if (accessed)
+      continue;
+    if (page_evict(f)) {
+      list_init(&f->pages);
+      f->ref_cnt = 0;
+      return f;
+    }
+  }
+  return NULL;
+}
+
+/* Adds page P to frame F.  frame_lock must be held. */
+static void frame_attach(struct frame* f, struct page* p) {
+  list_push_back(&f->pages, &p->frame_elem);
+  f->ref_cnt++;
+  f->pin_cnt += p->pin_cnt;
+  p->frame = f;
+}
+
+/* Removes page P from frame F.  frame_lock must be held. */
+static void frame_detach(struct frame* f, struct page* p) {
+  list_remove(&p->frame_elem);
+  f->ref_cnt--;
+  f->pin_cnt -= p->pin_cnt;
+  p->frame = NULL;
+}
+
+/* Removes empty frame F from the frame table and frees it.
+   frame_lock must be held. */
+static void frame_free(struct frame* f) {
+  ASSERT(f->ref_cnt == 0 && f->pin_cnt == 0);
+
+  if (hand == &f->elem)
+    hand = list_next(hand);
+  list_remove(&f->elem);
+  palloc_free_page(f->kpage);
+  free(f);
+}
@@ -0,0 +1,28 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+#include <stdbool.h>
+
+struct page;
+
+/* A frame of user memory holding a page.  After fork(), several
+   processes' copies of a page may share one frame until one of
+   them writes to it. */
+struct frame {
+  struct list_elem elem; /* Element in the frame table. */
+  void* kpage;           /* Kernel virtual address of the frame. */
+  struct list pages;     /* Pages sharing the frame. */
+  unsigned ref_cnt;      /* Number of pages in PAGES. */
+  unsigned pin_cnt;      /* Sum of the pages' pin counts. */
+};
+
+void frame_init(void);
+struct frame* frame_alloc(struct page*);
+bool frame_pin(struct page*);
+void frame_unpin(struct page*);
+void frame_discard(struct page*);
+bool frame_unshare(struct page*);
+bool frame_fork(struct page* parent, struct page* child);
+
+#endif /* vm/frame.h */
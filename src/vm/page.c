@@ -0,0 +1,605 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/* Supplemental page table.
+
+   load() does not read an executable into memory.  It only
+   records, for each page of each segment, which part of the file
+   the page starts out as, and leaves the page unmapped.  The
+   first access to the page then faults, and page_fault_in()
+   allocates a frame, reads the page's contents into it, and maps
+   it.  A program therefore starts without paying for the pages
+   it never touches, which for most programs is most of them.
+
+   Each process's pages are protected by its own page table lock,
+   which also keeps two of its threads from faulting in the same
+   page at once.
+
+   Once in memory, a page may be evicted again to make room for
+   another (see vm/frame.c).  A page that the process has never
+   written is simply dropped and read in from its file, or zeroed,
+   the next time it is touched.  A page that has been written goes
+   to swap, and from then on always goes back to swap when it is
+   evicted.
+
+   mmap() maps a file by adding a single struct mapping to the
+   page table, however long the file.  A fault on a mapped
+   address that is not in the table yet adds the page then, and
+   reads it in from the file like a page of the executable.
+   Mapped pages never go to swap: if the process has written to
+   one, it is written back to the file when it is evicted, when
+   the file is unmapped, or when the process exits.
+
+   fork() gives the child a page table of its own with a copy of
+   each of the parent's pages, but the copies share the frames
+   and swap slots that hold the originals until one process or
+   the other writes to them (see vm/frame.c).  Mapped files are
+   not inherited.
+
+   Locks are always taken in the order: page table lock, frame
+   table lock, then swap or file system locks.  Eviction runs
+   with only the frame table lock held, never the lock of the
+   page table whose page it evicts. */
+
+extern struct lock file_lock;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_free;
+static struct page* page_lookup(struct page_table*, const void* upage);
+static struct page* page_lookup_unpinned(struct page_table*, const void* upage);
+static struct page* page_find(struct page_table*, const void* upage);
+static struct page* page_create(struct page_table*, void* upage, struct file*, off_t ofs,
+                                size_t read_bytes, bool writable);
+static void page_write_back(struct page*, const void* kpage);
+static void mapping_destroy(struct page_table*, struct mapping*);
+static bool page_load(struct page_table*, struct page*, bool pin);
+static bool page_pin_one(struct page_table*, const void* upage, bool write);
+static void page_unpin_range(struct page_table*, const uint8_t* first, const uint8_t* end);
+
+/* Initializes PT as an empty page table.  Returns false if
+   memory cannot be allocated. */
+bool page_table_init(struct page_table* pt) {
+  lock_init(&pt->lock);
+  cond_init(&pt->unpinned);
+  pt->pd = NULL;
+  pt->resident_cnt = 0;
+  pt->image_start = pt->image_end = NULL;
+  list_init(&pt->mappings);
+  pt->next_mapid = 0;
+  return hash_init(&pt->pages, page_hash, page_less, NULL);
+}
+
+/* Frees PT and every page recorded in it, along with the frames
+   and swap slots that hold them, after unmapping every mapped
+   file.  Must be called before PT's page directory is
+   destroyed. */
+void page_table_destroy(struct page_table* pt) {
+  lock_acquire(&pt->lock);
+  while (!list_empty(&pt->mappings))
+    mapping_destroy(pt, list_entry(list_front(&pt->mappings), struct mapping, elem));
+  lock_release(&pt->lock);
+  hash_destroy(&pt->pages, page_free);
+}
+
+/* Copies every page of SRC except those of mapped files into
+   DST, which must be empty and have its page directory set, for
+   a child process created by fork().  Pages are not copied in
+   memory: each copy shares its original's frame or swap slot
+   until one of them is written.  The copies of pages of the
+   executable read from EXEC_FILE, the child's own handle on it.
+   Returns false if memory runs short, in which case the caller
+   must destroy DST. */
+bool page_table_fork(struct page_table* dst, struct page_table* src, struct file* exec_file) {
+  struct hash_iterator i;
+  bool success = true;
+
+  ASSERT(dst->pd != NULL);
+
+  lock_acquire(&src->lock);
+  lock_acquire(&dst->lock);
+  hash_first(&i, &src->pages);
+  while (success && hash_next(&i)) {
+    struct page* p = hash_entry(hash_cur(&i), struct page, elem);
+    struct page* c;
+
+    if (p->mapping != NULL)
+      continue;
+    c = page_create(dst, p->upage, p->file != NULL ? exec_file : NULL, p->ofs, p->read_bytes,
+                    p->writable);
+    if (c != NULL) {
+      c->touched = p->touched;
+      success = frame_fork(p, c);
+    } else
+      success = false;
+  }
+  dst->resident_cnt = src->resident_cnt;
+  dst->image_start = src->image_start;
+  dst->image_end = src->image_end;
+  lock_release(&dst->lock);
+  lock_release(&src->lock);
+  return success;
+}
+
+/* Records that user page UPAGE, which is not mapped yet, starts
+   out as READ_BYTES bytes of FILE at offset OFS followed by
+   zeros, or as all zeros if FILE is null, and may be written by
+   the process if WRITABLE is true.  PT's page directory must
+   already be set.  Returns false if UPAGE is already recorded or
+   if memory cannot be allocated. */
+bool page_record(struct page_table* pt, void* upage, struct file* file, off_t ofs,
+                 size_t read_bytes, bool writable) {
+  bool success;
+
+  ASSERT(pg_ofs(upage) == 0);
+  ASSERT(read_bytes <= PGSIZE);
+  ASSERT(file != NULL || read_bytes == 0);
+  ASSERT(pt->pd != NULL);
+
+  lock_acquire(&pt->lock);
+  success = page_create(pt, upage, file, ofs, read_bytes, writable) != NULL;
+  if (success && file != NULL) {
+    /* Keep track of where the executable lies, so that mmap()
+       can keep clear of it. */
+    if (pt->image_start == NULL || (uint8_t*)upage < pt->image_start)
+      pt->image_start = upage;
+    if ((uint8_t*)upage + PGSIZE > pt->image_end)
+      pt->image_end = (uint8_t*)upage + PGSIZE;
+  }
+  lock_release(&pt->lock);
+  return success;
+}
+
+/* Removes user page UPAGE from PT, freeing the memory or swap
+   slot that holds it, after waiting for any system call that has
+   it pinned to finish with it.  Returns false if UPAGE is not
+   recorded. */
+bool page_remove(struct page_table* pt, void* upage) {
+  struct page* p;
+
+  lock_acquire(&pt->lock);
+  p = page_lookup_unpinned(pt, upage);
+  if (p != NULL)
+    hash_delete(&pt->pages, &p->elem);
+  lock_release(&pt->lock);
+  if (p == NULL)
+    return false;
+  page_free(&p->elem, NULL);
+  return true;
+}
+
+/* Makes sure the page containing user address ADDR is in memory
+   and mapped in the running process's page directory, reading it
+   in from its file or from swap if necessary.  Returns true if
+   successful, false if the process has no page at ADDR or if it
+   cannot be read in. */
+bool page_fault_in(const void* addr) {
+  struct process* pcb = thread_current()->pcb;
+  struct page_table* pt;
+  struct page* p;
+  bool success;
+
+  if (pcb == NULL || pcb->pagedir == NULL || !is_user_vaddr(addr))
+    return false;
+  pt = &pcb->pages;
+
+  lock_acquire(&pt->lock);
+  p = page_find(pt, pg_round_down(addr));
+  if (p == NULL)
+    success = false;
+  else if (pagedir_get_page(pcb->pagedir, p->upage) != NULL)
+    success = true; /* Another thread faulted it in first. */
+  else
+    success = page_load(pt, p, false);
+  lock_release(&pt->lock);
+  return success;
+}
+
+/* Handles a write by the running process to the page containing
+   user address ADDR, which is mapped read-only.  If the page is
+   in fact writable and has only been mapped read-only because it
+   is shared with another process since fork(), gives the process
+   a copy of its own and maps it writable.  Returns false if the
+   page really is read-only or is not in the process's page
+   table, or if no frame can be found for the copy. */
+bool page_copy_on_write(const void* addr) {
+  struct process* pcb = thread_current()->pcb;
+  struct page_table* pt;
+  struct page* p;
+  bool success;
+
+  if (pcb == NULL || pcb->pagedir == NULL || !is_user_vaddr(addr))
+    return false;
+  pt = &pcb->pages;
+
+  lock_acquire(&pt->lock);
+  p = page_lookup(pt, pg_round_down(addr));
+  success = p != NULL && p->writable && frame_unshare(p);
+  lock_release(&pt->lock);
+  return success;
+}
+
+/* Brings the SIZE bytes of user memory starting at ADDR into
+   memory and keeps them there until page_unpin() is called, so
+   that the kernel can access them without faulting, for example
+   while it holds a lock that page faults need too.  If WRITE is
+   true, the kernel is going to write to them, so pages shared
+   since fork() are copied first.  Returns false, pinning nothing,
+   if part of the range is not recorded in the running process's
+   page table, cannot be read in, or is read-only when WRITE is
+   true. */
+bool page_pin(const void* addr, size_t size, bool write) {
+  struct page_table* pt = &thread_current()->pcb->pages;
+  const uint8_t* first = pg_round_down(addr);
+  const uint8_t* end = (const uint8_t*)addr + size;
+  const uint8_t* upage;
+
+  for (upage = first; upage < end; upage += PGSIZE)
+    if (!page_pin_one(pt, upage, write)) {
+      page_unpin_range(pt, first, upage);
+      return false;
+    }
+  return true;
+}
+
+/* Undoes page_pin() of the SIZE bytes starting at ADDR. */
+void page_unpin(const void* addr, size_t size) {
+  struct page_table* pt = &thread_current()->pcb->pages;
+  page_unpin_range(pt, pg_round_down(addr), (const uint8_t*)addr + size);
+}
+
+/* Evicts the pages in frame F, of which there are several if
+   processes share it since fork(), writing the frame to swap
+   first if it may differ from the pages' file.  The pages then
+   share the swap slot.  Returns false, leaving the pages in
+   place, if the frame has to be written to swap but swap is
+   full.  The frame table lock must be held and F must not be
+   pinned.  The caller takes the pages off F's list. */
+bool page_evict(struct frame* f) {
+  struct page* first = list_entry(list_front(&f->pages), struct page, frame_elem);
+  struct list_elem* e;
+  size_t slot = SWAP_NONE;
+  bool dirty = false;
+
+  /* Unmap the pages before checking the dirty bits, so that no
+     process can write to the frame once we have looked. */
+  for (e = list_begin(&f->pages); e != list_end(&f->pages); e = list_next(e)) {
+    struct page* p = list_entry(e, struct page, frame_elem);
+    pagedir_clear_page(p->pd, p->upage);
+    if (p->dirty || pagedir_is_dirty(p->pd, p->upage))
+      dirty = true;
+  }
+
+  if (first->mapping != NULL) {
+    /* Mapped pages are never shared. */
+    if (dirty)
+      page_write_back(first, f->kpage);
+  } else if (dirty) {
+    slot = swap_out(f->kpage);
+    if (slot == SWAP_NONE) {
+      for (e = list_begin(&f->pages); e != list_end(&f->pages); e = list_next(e)) {
+        struct page* p = list_entry(e, struct page, frame_elem);
+        pagedir_set_page(p->pd, p->upage, f->kpage, p->writable && f->ref_cnt == 1);
+        p->dirty = true;
+      }
+      return false;
+    }
+  }
+
+  for (e = list_begin(&f->pages); e != list_end(&f->pages); e = list_next(e)) {
+    struct page* p = list_entry(e, struct page, frame_elem);
+    if (slot != SWAP_NONE) {
+      p->swap_slot = p == first ? slot : swap_dup(slot);
+      p->dirty = true;
+    }
+    p->frame = NULL;
+  }
+  return true;
+}
+
+/* Maps FILE, which the caller has reopened for the purpose, into
+   PT's address space starting at ADDR, and returns an identifier
+   for the mapping, or -1 if FILE is empty, ADDR is null or not
+   page-aligned, or the pages that would be mapped overlap the
+   executable, a stack region, or another mapping.  On success,
+   the mapping owns FILE and closes it when it is unmapped.  No
+   page of FILE is read until the process touches it. */
+int page_map(struct page_table* pt, struct file* file, void* addr) {
+  uint8_t* base = addr;
+  uint8_t* limit = (uint8_t*)PHYS_BASE - STACK_REGION_CNT * STACK_REGION_SIZE;
+  uint8_t* end;
+  struct mapping* m;
+  struct list_elem* e;
+  off_t length;
+  int id = -1;
+
+  lock_acquire(&file_lock);
+  length = file_length(file);
+  lock_release(&file_lock);
+  if (length == 0 || base == NULL || pg_ofs(base) != 0)
+    return -1;
+
+  /* The mapping must end below the stack regions. */
+  if (base >= limit || (size_t)length > (size_t)(limit - base))
+    return -1;
+  end = base + ROUND_UP(length, PGSIZE);
+
+  lock_acquire(&pt->lock);
+  if (base < pt->image_end && pt->image_start < end)
+    goto done;
+  for (e = list_begin(&pt->mappings); e != list_end(&pt->mappings); e = list_next(e)) {
+    m = list_entry(e, struct mapping, elem);
+    if (base < m->base + ROUND_UP(m->length, PGSIZE) && m->base < end)
+      goto done;
+  }
+
+  m = malloc(sizeof *m);
+  if (m != NULL) {
+    m->id = id = pt->next_mapid++;
+    m->file = file;
+    m->base = base;
+    m->length = length;
+    m->unmapping = false;
+    list_push_back(&pt->mappings, &m->elem);
+  }
+
+done:
+  lock_release(&pt->lock);
+  return id;
+}
+
+/* Unmaps mapping MAPID from PT, writing back every page that the
+   process has written to.  Returns false if PT has no such
+   mapping. */
+bool page_unmap(struct page_table* pt, int mapid) {
+  struct list_elem* e;
+  bool found = false;
+
+  lock_acquire(&pt->lock);
+  for (e = list_begin(&pt->mappings); e != list_end(&pt->mappings); e = list_next(e)) {
+    struct mapping* m = list_entry(e, struct mapping, elem);
+    if (m->id == mapid && !m->unmapping) {
+      mapping_destroy(pt, m);
+      found = true;
+      break;
+    }
+  }
+  lock_release(&pt->lock);
+  return found;
+}
+
+/* Reads page P in PT into a frame and maps it.  If PIN is true,
+   the frame stays pinned.  Returns true if successful, false if
+   no frame can be found or the file cannot be read.  PT's lock
+   must be held. */
+static bool page_load(struct page_table* pt, struct page* p, bool pin) {
+  struct frame* f = frame_alloc(p);
+  uint8_t* kpage;
+
+  if (f == NULL)
+    return false;
+  kpage = f->kpage;
+
+  if (p->swap_slot != SWAP_NONE) {
+    swap_in(p->swap_slot, kpage);
+    p->swap_slot = SWAP_NONE;
+  } else {
+    off_t bytes_read = 0;
+
+    if (p->read_bytes > 0) {
+      lock_acquire(&file_lock);
+      bytes_read = file_read_at(p->file, kpage, p->read_bytes, p->ofs);
+      lock_release(&file_lock);
+    }
+    if (bytes_read != (off_t)p->read_bytes)
+      goto fail;
+    memset(kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+  }
+
+  if (!pagedir_set_page(p->pd, p->upage, kpage, p->writable))
+    goto fail;
+  if (!pin)
+    frame_unpin(p);
+
+  /* Count executable pages the first time they come in. */
+  if (!p->touched && p->file != NULL && p->mapping == NULL)
+    pt->resident_cnt++;
+  p->touched = true;
+  return true;
+
+fail:
+  frame_unpin(p);
+  frame_discard(p);
+  return false;
+}
+
+/* Pins the page at UPAGE in PT, reading it in if necessary, and
+   if WRITE is true, gives the process its own copy of it if it
+   is shared.  Returns false if there is no such page, it cannot
+   be read in or copied, or WRITE is true and it is read-only. */
+static bool page_pin_one(struct page_table* pt, const void* upage, bool write) {
+  struct page* p;
+  bool success;
+
+  lock_acquire(&pt->lock);
+  p = page_find(pt, upage);
+  if (p == NULL || (write && !p->writable))
+    success = false;
+  else {
+    success = frame_pin(p) || page_load(pt, p, true);
+    if (success && write && !frame_unshare(p)) {
+      frame_unpin(p);
+      success = false;
+    }
+  }
+  lock_release(&pt->lock);
+  return success;
+}
+
+/* Unpins the pages in PT from FIRST up to END, all of which must
+   have been pinned by page_pin_one(). */
+static void page_unpin_range(struct page_table* pt, const uint8_t* first, const uint8_t* end) {
+  const uint8_t* upage;
+
+  lock_acquire(&pt->lock);
+  for (upage = first; upage < end; upage += PGSIZE) {
+    struct page* p = page_lookup(pt, upage);
+    if (p != NULL)
+      frame_unpin(p);
+  }
+  cond_broadcast(&pt->unpinned, &pt->lock);
+  lock_release(&pt->lock);
+}
+
+/* Returns the page in PT at user virtual address UPAGE, or a null
+   pointer if there is none.  PT's lock must be held. */
+static struct page* page_lookup(struct page_table* pt, const void* upage) {
+  struct page key;
+  struct hash_elem* e;
+
+  key.upage = (void*)upage;
+  e = hash_find(&pt->pages, &key.elem);
+  return e != NULL ? hash_entry(e, struct page, elem) : NULL;
+}
+
+/* Returns the page in PT at user virtual address UPAGE, or a null
+   pointer if there is none, once no system call has it pinned.
+   PT's lock must be held.  It is released while waiting, so PT
+   may change in the meantime. */
+static struct page* page_lookup_unpinned(struct page_table* pt, const void* upage) {
+  struct page* p;
+
+  while ((p = page_lookup(pt, upage)) != NULL && p->pin_cnt > 0)
+    cond_wait(&pt->unpinned, &pt->lock);
+  return p;
+}
+
+/* Returns the page in PT at user virtual address UPAGE, adding it
+   to PT first if it lies in a mapped file that has not been
+   touched there yet.  Returns a null pointer if UPAGE is neither
+   recorded nor mapped, or if memory cannot be allocated.  PT's
+   lock must be held. */
+static struct page* page_find(struct page_table* pt, const void* upage) {
+  struct page* p = page_lookup(pt, upage);
+  struct list_elem* e;
+
+  if (p != NULL)
+    return p;
+  for (e = list_begin(&pt->mappings); e != list_end(&pt->mappings); e = list_next(e)) {
+    struct mapping* m = list_entry(e, struct mapping, elem);
+    off_t ofs = (const uint8_t*)upage - m->base;
+
+    if ((const uint8_t*)upage >= m->base && ofs < m->length && !m->unmapping) {
+      size_t read_bytes = m->length - ofs < PGSIZE ? m->length - ofs : PGSIZE;
+
+      p = page_create(pt, (void*)upage, m->file, ofs, read_bytes, true);
+      if (p != NULL)
+        p->mapping = m;
+      return p;
+    }
+  }
+  return NULL;
+}
+
+/* Adds a page at UPAGE to PT, as described for page_record(), and
+   returns it.  Returns a null pointer if UPAGE is already in PT or
+   if memory cannot be allocated.  PT's lock must be held. */
+static struct page* page_create(struct page_table* pt, void* upage, struct file* file, off_t ofs,
+                                size_t read_bytes, bool writable) {
+  struct page* p = malloc(sizeof *p);
+
+  if (p == NULL)
+    return NULL;
+  p->upage = upage;
+  p->writable = writable;
+  p->file = file;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  p->mapping = NULL;
+  p->pd = pt->pd;
+  p->frame = NULL;
+  p->pin_cnt = 0;
+  p->swap_slot = SWAP_NONE;
+  p->dirty = false;
+  p->touched = false;
+
+  if (hash_insert(&pt->pages, &p->elem) != NULL) {
+    free(p);
+    return NULL;
+  }
+  return p;
+}
+
+/* Writes mapped page P, whose contents are at KPAGE, back to its
+   file. */
+static void page_write_back(struct page* p, const void* kpage) {
+  lock_acquire(&file_lock);
+  file_write_at(p->file, kpage, p->read_bytes, p->ofs);
+  lock_release(&file_lock);
+}
+
+/* Writes back the written pages of mapping M, removes them and M
+   from PT, and closes M's file.  Pages that a system call has
+   pinned are removed once it unpins them.  PT's lock must be
+   held. */
+static void mapping_destroy(struct page_table* pt, struct mapping* m) {
+  uint8_t* upage;
+
+  /* Stop faults from adding pages to M, and other threads from
+     unmapping it too, while we wait for pinned pages. */
+  m->unmapping = true;
+  for (upage = m->base; upage < m->base + m->length; upage += PGSIZE) {
+    struct page* p = page_lookup_unpinned(pt, upage);
+    if (p == NULL)
+      continue;
+
+    /* Only a page in memory can have been written since it was
+       last written back.  Pin it so that eviction cannot write
+       it back at the same time. */
+    if (frame_pin(p)) {
+      if (p->dirty || pagedir_is_dirty(p->pd, p->upage))
+        page_write_back(p, p->frame->kpage);
+      frame_unpin(p);
+    }
+    hash_delete(&pt->pages, &p->elem);
+    page_free(&p->elem, NULL);
+  }
+
+  list_remove(&m->elem);
+  lock_acquire(&file_lock);
+  file_close(m->file);
+  lock_release(&file_lock);
+  free(m);
+}
+
+/* Returns a hash value for page E. */
+static unsigned page_hash(const struct hash_elem* e, void* aux UNUSED) {
+  const struct page* p = hash_entry(e, struct page, elem);
+  return hash_int((uintptr_t)p->upage >> PGBITS);
+}
+
+/* Returns true if page A precedes page B. */
+static bool page_less(const struct hash_elem* a_, const struct hash_elem* b_, void* aux UNUSED) {
+  const struct page* a = hash_entry(a_, struct page, elem);
+  const struct page* b = hash_entry(b_, struct page, elem);
+  return a->upage < b->upage;
+}
+
+/* Frees page E, along with its frame and swap slot. */
+static void page_free(struct hash_elem* e, void* aux UNUSED) {
+  struct page* p = hash_entry(e, struct page, elem);
+
+  frame_discard(p);
+  free(p);
+}
@@ -0,0 +1,81 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+struct file;
+struct frame;
+
+/* A file mapped into a process's address space by mmap().  Its
+   pages are only added to the page table as the process touches
+   them. */
+struct mapping {
+  struct list_elem elem; /* Element in struct page_table's mappings. */
+  int id;                /* Mapping identifier. */
+  struct file* file;     /* The mapped file, reopened for the mapping. */
+  uint8_t* base;         /* First mapped page. */
+  off_t length;          /* Bytes mapped: the length of FILE. */
+  bool unmapping;        /* Being unmapped?  Then no new pages. */
+};
+
+/* A page of a process's address space that is not necessarily in
+   memory: the supplemental page table records where its contents
+   come from until the process first touches it. */
+struct page {
+  struct hash_elem elem; /* Element in struct page_table's pages. */
+  void* upage;           /* User virtual address. */
+  bool writable;         /* May the process write to the page? */
+
+  /* Initial contents: READ_BYTES bytes of FILE starting at OFS,
+     followed by zeros to the end of the page. */
+  struct file* file;       /* File to read from, or NULL for a zero page. */
+  off_t ofs;               /* Offset in FILE. */
+  size_t read_bytes;       /* Bytes to read from FILE. */
+  struct mapping* mapping; /* If nonnull, FILE is written back, not swapped. */
+
+  /* Where the page is now.  Protected by the frame table lock. */
+  uint32_t* pd;                /* Page directory the page is mapped in. */
+  struct frame* frame;         /* Frame holding the page, or NULL. */
+  struct list_elem frame_elem; /* Element in FRAME's list of pages. */
+  unsigned pin_cnt;            /* Times pinned in FRAME. */
+  size_t swap_slot;            /* Swap slot holding the page, or SWAP_NONE. */
+  bool dirty;                  /* Differs from FILE?  Then it goes to swap. */
+  bool touched;                /* Ever brought into memory? */
+};
+
+/* Supplemental page table, one per process. */
+struct page_table {
+  struct hash pages;         /* Pages, hashed by user virtual address. */
+  uint32_t* pd;              /* Page directory the pages are mapped in. */
+  struct lock lock;          /* Serializes faults and changes to PAGES. */
+  struct condition unpinned; /* Signaled under LOCK when pages are unpinned. */
+  size_t resident_cnt;       /* Executable pages brought in so far. */
+  uint8_t* image_start;      /* Lowest page of the executable. */
+  uint8_t* image_end;        /* End of the executable's highest page. */
+  struct list mappings;      /* Files mapped by mmap(). */
+  int next_mapid;            /* Identifier for the next mapping. */
+};
+
+bool page_table_init(struct page_table*);
+void page_table_destroy(struct page_table*);
+bool page_table_fork(struct page_table* dst, struct page_table* src, struct file* exec_file);
+
+bool page_record(struct page_table*, void* upage, struct file*, off_t ofs, size_t read_bytes,
+                 bool writable);
+bool page_remove(struct page_table*, void* upage);
+bool page_fault_in(const void* addr);
+bool page_copy_on_write(const void* addr);
+bool page_pin(const void* addr, size_t size, bool write);
+void page_unpin(const void* addr, size_t size);
+bool page_evict(struct frame*);
+
+int page_map(struct page_table*, struct file*, void* addr);
+bool page_unmap(struct page_table*, int mapid);
+
+#endif /* vm/page.h */
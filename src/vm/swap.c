@@ -0,0 +1,87 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Swap space.
+
+   The swap block device is divided into page-sized slots, and a
+   bitmap records which of them are in use.  Each page goes to
+   swap or comes back from it as a single multi-sector transfer,
+   rather than one request per sector.
+
+   A page that a fork() shares between processes goes to swap
+   only once, and every process's copy of it then refers to the
+   same slot, so each slot has a reference count. */
+
+/* Sectors per page-sized swap slot. */
+#define SECTORS_PER_SLOT (PGSIZE / BLOCK_SECTOR_SIZE)
+
+static struct block* swap_device; /* Swap device, or NULL if none. */
+static struct bitmap* used_slots; /* Slots in use. */
+static unsigned* slot_refs;       /* Reference count of each slot in use. */
+static struct lock swap_lock;     /* Protects USED_SLOTS and SLOT_REFS. */
+
+/* Sets up swap on the swap block device, if there is one.
+   Without one, pages that would have to be swapped out cannot
+   be evicted. */
+void swap_init(void) {
+  size_t slot_cnt = 0;
+
+  lock_init(&swap_lock);
+  swap_device = block_get_role(BLOCK_SWAP);
+  if (swap_device != NULL)
+    slot_cnt = block_size(swap_device) / SECTORS_PER_SLOT;
+
+  used_slots = bitmap_create(slot_cnt);
+  slot_refs = calloc(slot_cnt, sizeof *slot_refs);
+  if (used_slots == NULL || (slot_cnt > 0 && slot_refs == NULL))
+    PANIC("swap slot bitmap creation failed");
+}
+
+/* Writes the page at KPAGE to a free swap slot and returns the
+   slot, or SWAP_NONE if swap is full. */
+size_t swap_out(const void* kpage) {
+  size_t slot;
+
+  lock_acquire(&swap_lock);
+  slot = bitmap_scan_and_flip(used_slots, 0, 1, false);
+  if (slot != BITMAP_ERROR)
+    slot_refs[slot] = 1;
+  lock_release(&swap_lock);
+  if (slot == BITMAP_ERROR)
+    return SWAP_NONE;
+
+  block_write_multi(swap_device, slot * SECTORS_PER_SLOT, kpage, SECTORS_PER_SLOT);
+  return slot;
+}
+
+/* Reads the page in swap slot SLOT into KPAGE and drops one
+   reference to the slot. */
+void swap_in(size_t slot, void* kpage) {
+  block_read_multi(swap_device, slot * SECTORS_PER_SLOT, kpage, SECTORS_PER_SLOT);
+  swap_free(slot);
+}
+
+/* Adds a reference to swap slot SLOT, for another process's copy
+   of the page in it, and returns SLOT. */
+size_t swap_dup(size_t slot) {
+  lock_acquire(&swap_lock);
+  ASSERT(bitmap_test(used_slots, slot));
+  slot_refs[slot]++;
+  lock_release(&swap_lock);
+  return slot;
+}
+
+/* Drops one reference to swap slot SLOT without reading it,
+   freeing the slot when the last reference goes. */
+void swap_free(size_t slot) {
+  lock_acquire(&swap_lock);
+  ASSERT(bitmap_test(used_slots, slot));
+  if (--slot_refs[slot] == 0)
+    bitmap_reset(used_slots, slot);
+  lock_release(&swap_lock);
+}